@@ -0,0 +1,49 @@
+#ifndef CACHE_LINE_HPP
+#define CACHE_LINE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <new>
+
+// Alignment that keeps data written by different threads on separate cache lines - shared by all exercises.
+// std::hardware_destructive_interference_size is not used - its value depends on the compiler version and -mtune,
+// so the layout of classes defined in headers could differ between translation units.
+inline constexpr size_t cache_line_size = 64;
+
+// Allocator of arrays starting at a cache line boundary - element i of e.g. std::vector<int64_t, CacheAlignedAllocator<int64_t>>
+// shares a cache line only with elements of the same index / (cache_line_size / sizeof(int64_t)).
+template <typename T>
+struct CacheAlignedAllocator
+{
+    using value_type = T;
+
+    static constexpr std::align_val_t alignment{std::max(cache_line_size, alignof(T))};
+
+    CacheAlignedAllocator() = default;
+
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) noexcept
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length{};
+        return static_cast<T*>(::operator new(n * sizeof(T), alignment));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept
+    {
+        ::operator delete(ptr, n * sizeof(T), alignment);
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+};
+
+#endif // CACHE_LINE_HPP
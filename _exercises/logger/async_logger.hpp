@@ -0,0 +1,554 @@
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+
+#include "binary_log.hpp"
+#include "log_sinks.hpp"
+#include "spsc_ring_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+enum class OverflowPolicy
+{
+    block, // producer waits until the writer thread frees space in its buffer
+    drop   // message is dropped and counted - producer never waits
+};
+
+enum class Severity : uint32_t
+{
+    debug,
+    info,
+    warning,
+    error,
+    critical,
+    off // threshold only - no record has this severity
+};
+
+enum class LogOutput
+{
+    text,  // records are formatted on the writer thread
+    binary // records are stored in binary form - use log-decoder to read them
+};
+
+// Records are written to the sink in batches - the sink is flushed when any of the conditions is met
+struct FlushPolicy
+{
+    size_t every_records = 1;                   // at least that many records are not flushed (1 - after every batch, 0 - never)
+    std::chrono::milliseconds every_interval{0}; // unflushed records are older than the interval (0 - never)
+    Severity on_severity = Severity::error;     // a record of at least that severity has been written
+};
+
+struct AsyncLoggerOptions
+{
+    size_t buffer_capacity = 64 * 1024; // bytes of the ring buffer of each producer thread
+    OverflowPolicy overflow_policy = OverflowPolicy::block;
+    LogOutput output = LogOutput::text;
+    std::chrono::microseconds max_idle_sleep{1000}; // polling interval of an idle writer thread
+    Severity min_severity = Severity::debug;        // can be changed with set_min_severity()
+    FlushPolicy flush_policy = {};
+};
+
+// Thread-safe logger with asynchronous output.
+//
+// log() copies the message into a lock-free ring buffer owned by the calling thread.
+// A single background thread drains all buffers, orders the records of a batch by their
+// timestamps and writes them to the sink with one write per batch. The sink is flushed according
+// to FlushPolicy or when flush() is called.
+// Messages longer than half of the buffer capacity are truncated.
+//
+// log<"format {}">(args...) defers formatting - only a format id and raw arguments are copied
+// on the calling thread (see binary_log.hpp).
+// Records below min_severity are discarded - macros in log_filters.hpp skip them before
+// arguments are evaluated and add sampling and rate limiting.
+class AsyncLogger
+{
+public:
+    explicit AsyncLogger(std::unique_ptr<LogSink> sink, AsyncLoggerOptions options = {})
+        : options_{options}
+        , sink_{std::move(sink)}
+        , writer_{[this](std::stop_token stop_token) { write_loop(stop_token); }}
+    {
+    }
+
+    explicit AsyncLogger(const std::string& file_name, AsyncLoggerOptions options = {})
+        : AsyncLogger{std::make_unique<FileSink>(file_name), options}
+    {
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    ~AsyncLogger()
+    {
+        writer_.request_stop();
+        writer_.join(); // writer drains all buffers before it finishes
+
+        std::lock_guard lk{buffers_mtx_};
+        for (auto& buffer : buffers_)
+            buffer->is_logger_closed.store(true);
+    }
+
+    void log(std::string_view message)
+    {
+        log(Severity::info, message);
+    }
+
+    void log(Severity severity, std::string_view message)
+    {
+        if (!is_enabled(severity))
+            return;
+
+        message = message.substr(0, max_record_size_ - sizeof(RecordHeader) - sizeof(uint32_t));
+
+        append_record(severity, BinaryLog::FormatRegistry::plain_text_id, BinaryLog::raw_size(message), [message](std::byte* dest) {
+            BinaryLog::encode_raw(dest, message);
+        });
+    }
+
+    template <BinaryLog::FormatString Fmt, typename... TArgs>
+    void log(const TArgs&... args)
+    {
+        log<Fmt>(Severity::info, args...);
+    }
+
+    template <BinaryLog::FormatString Fmt, typename... TArgs>
+    void log(Severity severity, const TArgs&... args)
+    {
+        if (!is_enabled(severity))
+            return;
+
+        log_unfiltered<Fmt>(severity, args...);
+    }
+
+    // barrier - waits until all records logged before the call are written and the sink is flushed (see LogSink::flush)
+    void flush()
+    {
+        const uint64_t request = flush_requests_.fetch_add(1) + 1;
+
+        uint64_t completed;
+        while ((completed = completed_flush_requests_.load()) < request)
+            completed_flush_requests_.wait(completed);
+    }
+
+    // number of flushes of the sink made so far
+    uint64_t flush_count() const
+    {
+        return flush_count_.load(std::memory_order_relaxed);
+    }
+
+    bool is_enabled(Severity severity) const
+    {
+        return severity >= min_severity_.load(std::memory_order_relaxed);
+    }
+
+    void set_min_severity(Severity severity)
+    {
+        min_severity_.store(severity, std::memory_order_relaxed);
+    }
+
+    Severity min_severity() const
+    {
+        return min_severity_.load(std::memory_order_relaxed);
+    }
+
+    // counts messages skipped by sampling or rate limiting - reported in the log by the writer thread
+    // (a relaxed add to a counter of the calling thread - no other thread writes to its cache line)
+    void count_suppressed(uint64_t count)
+    {
+        thread_buffer().suppressed.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    uint64_t dropped_count() const
+    {
+        std::lock_guard lk{buffers_mtx_};
+        return dropped_by_finished_threads_ + sum_counter(buffers_, &ThreadBuffer::dropped);
+    }
+
+    uint64_t suppressed_count() const
+    {
+        std::lock_guard lk{buffers_mtx_};
+        return suppressed_by_finished_threads_ + sum_counter(buffers_, &ThreadBuffer::suppressed);
+    }
+
+private:
+    struct RecordHeader
+    {
+        uint64_t timestamp_ns;
+        uint32_t format_id;
+        Severity severity;
+    };
+
+    struct ThreadBuffer
+    {
+        explicit ThreadBuffer(size_t capacity)
+            : ring{capacity}
+        {
+        }
+
+        SpscRingBuffer ring;
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<bool> is_orphaned{false};      // producer thread has finished
+        std::atomic<bool> is_logger_closed{false}; // logger has been destroyed
+        // written by filtered call sites - on its own cache line, apart from fields read by the writer thread on every drain
+        alignas(cache_line_size) std::atomic<uint64_t> suppressed{0};
+    };
+
+    // buffers of the current thread - one per logger it writes to
+    struct ThreadBuffers
+    {
+        std::vector<std::pair<uint64_t, std::shared_ptr<ThreadBuffer>>> items;
+
+        ~ThreadBuffers()
+        {
+            for (auto& [logger_id, buffer] : items)
+                buffer->is_orphaned.store(true, std::memory_order_release);
+        }
+    };
+
+    struct DrainResult
+    {
+        size_t written;  // number of written records
+        bool has_report; // a report of dropped or suppressed messages has been logged - written by the next drain
+    };
+
+    struct BatchEntry
+    {
+        uint64_t timestamp_ns;
+        uint32_t format_id;
+        size_t offset;
+        size_t size;
+    };
+
+    inline static std::atomic<uint64_t> next_logger_id_{1};
+
+    const uint64_t id_ = next_logger_id_++;
+    const AsyncLoggerOptions options_;
+    const size_t max_record_size_ = SpscRingBuffer::max_record_size(options_.buffer_capacity);
+    std::atomic<Severity> min_severity_{options_.min_severity};
+    std::unique_ptr<LogSink> sink_;
+
+    mutable std::mutex buffers_mtx_; // guards registration of producer threads only
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    uint64_t dropped_by_finished_threads_ = 0;
+    uint64_t suppressed_by_finished_threads_ = 0;
+
+    std::atomic<uint64_t> flush_requests_{0};
+    std::atomic<uint64_t> completed_flush_requests_{0};
+    std::atomic<uint64_t> flush_count_{0};
+
+    // used only by the writer thread
+    std::vector<std::shared_ptr<ThreadBuffer>> drained_buffers_;
+    std::vector<BatchEntry> batch_;
+    std::string batch_data_;
+    std::string output_;
+    uint64_t reported_dropped_ = 0;
+    uint64_t reported_suppressed_ = 0;
+    std::vector<BinaryLog::Format> formats_; // cache of FormatRegistry
+    std::vector<bool> written_formats_;      // format definitions already stored in the binary output
+    bool is_header_written_ = false;
+    uint64_t last_timestamp_ns_ = 0;
+    size_t unflushed_records_ = 0;
+    bool has_unflushed_severe_record_ = false;
+    std::chrono::steady_clock::time_point last_flush_time_ = std::chrono::steady_clock::now();
+
+    std::jthread writer_; // must be the last member
+
+    static uint64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t sum_counter(const std::vector<std::shared_ptr<ThreadBuffer>>& buffers, std::atomic<uint64_t> ThreadBuffer::*counter)
+    {
+        uint64_t sum = 0;
+        for (const auto& buffer : buffers)
+            sum += ((*buffer).*counter).load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    ThreadBuffer& thread_buffer()
+    {
+        thread_local ThreadBuffers thread_buffers;
+
+        for (auto& [logger_id, buffer] : thread_buffers.items)
+        {
+            if (logger_id == id_)
+                return *buffer;
+        }
+
+        return register_thread_buffer(thread_buffers);
+    }
+
+    ThreadBuffer& register_thread_buffer(ThreadBuffers& thread_buffers)
+    {
+        std::erase_if(thread_buffers.items, [](const auto& item) { return item.second->is_logger_closed.load(); });
+
+        auto buffer = std::make_shared<ThreadBuffer>(options_.buffer_capacity);
+        {
+            std::lock_guard lk{buffers_mtx_};
+            buffers_.push_back(buffer);
+        }
+        thread_buffers.items.emplace_back(id_, buffer);
+
+        return *buffer;
+    }
+
+    template <BinaryLog::FormatString Fmt, typename... TArgs>
+    void log_unfiltered(Severity severity, const TArgs&... args)
+    {
+        static_assert(Fmt.placeholders_count() == sizeof...(TArgs), "number of {} placeholders must match number of arguments");
+
+        const size_t args_size = (size_t{0} + ... + BinaryLog::raw_size(args));
+
+        append_record(severity, BinaryLog::format_id<Fmt, TArgs...>(), args_size, [&args...](std::byte* dest) {
+            ((dest = BinaryLog::encode_raw(dest, args)), ...);
+        });
+    }
+
+    template <typename TEncoder>
+    void append_record(Severity severity, uint32_t format_id, size_t args_size, TEncoder encode_args)
+    {
+        ThreadBuffer& buffer = thread_buffer();
+        const size_t record_size = sizeof(RecordHeader) + args_size;
+
+        if (record_size > max_record_size_)
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::byte* record = buffer.ring.try_reserve(record_size);
+        if (!record)
+        {
+            record = reserve_on_overflow(buffer, record_size);
+            if (!record)
+                return;
+        }
+
+        const RecordHeader header{now_ns(), format_id, severity};
+        std::memcpy(record, &header, sizeof(header));
+        encode_args(record + sizeof(header));
+        buffer.ring.commit();
+    }
+
+    std::byte* reserve_on_overflow(ThreadBuffer& buffer, size_t record_size)
+    {
+        if (options_.overflow_policy == OverflowPolicy::drop)
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        std::byte* record;
+        while (!(record = buffer.ring.try_reserve(record_size)))
+            std::this_thread::yield();
+
+        return record;
+    }
+
+    void write_loop(std::stop_token stop_token)
+    {
+        auto idle_sleep = std::chrono::microseconds{1};
+
+        while (!stop_token.stop_requested())
+        {
+            const uint64_t flush_request = flush_requests_.load(); // records logged before the request are drained below
+            const DrainResult result = drain();
+            flush_if_due(flush_request);
+
+            if (result.written > 0 || result.has_report)
+            {
+                idle_sleep = std::chrono::microseconds{1};
+            }
+            else
+            {
+                std::this_thread::sleep_for(idle_sleep);
+                idle_sleep = std::min(idle_sleep * 2, options_.max_idle_sleep);
+            }
+        }
+
+        for (DrainResult result = drain(); result.written > 0 || result.has_report; result = drain())
+        {
+        }
+        flush_sink();
+    }
+
+    // writes all records published so far
+    DrainResult drain()
+    {
+        {
+            std::lock_guard lk{buffers_mtx_};
+            drained_buffers_ = buffers_;
+        }
+
+        batch_.clear();
+        batch_data_.clear();
+
+        for (const auto& buffer : drained_buffers_)
+        {
+            const bool is_orphaned = buffer->is_orphaned.load(std::memory_order_acquire);
+
+            buffer->ring.consume([this](std::span<const std::byte> record) {
+                RecordHeader header;
+                std::memcpy(&header, record.data(), sizeof(header));
+
+                const auto args = record.subspan(sizeof(header));
+                batch_.push_back({header.timestamp_ns, header.format_id, batch_data_.size(), args.size()});
+                has_unflushed_severe_record_ |= header.severity >= options_.flush_policy.on_severity;
+                batch_data_.append(reinterpret_cast<const char*>(args.data()), args.size());
+            });
+
+            if (is_orphaned) // no more records will come from a finished thread
+                remove_buffer(buffer);
+        }
+
+        const bool has_dropped_report = report_dropped();
+        const bool has_suppressed_report = report_suppressed();
+        const bool has_report = has_dropped_report || has_suppressed_report;
+
+        if (batch_.empty())
+            return {0, has_report};
+
+        std::stable_sort(batch_.begin(), batch_.end(), [](const BatchEntry& a, const BatchEntry& b) { return a.timestamp_ns < b.timestamp_ns; });
+
+        if (sink_->roll_if_due()) // every binary file is decoded on its own
+        {
+            is_header_written_ = false;
+            written_formats_.clear();
+            last_timestamp_ns_ = 0;
+        }
+
+        output_.clear();
+        for (const auto& entry : batch_)
+        {
+            const std::span<const std::byte> args{reinterpret_cast<const std::byte*>(batch_data_.data()) + entry.offset, entry.size};
+            const BinaryLog::Format& format = cached_format(entry.format_id);
+
+            if (options_.output == LogOutput::text)
+            {
+                BinaryLog::format_message(output_, format, args);
+                output_.push_back('\n');
+            }
+            else
+            {
+                append_binary_record(entry, format, args);
+            }
+        }
+
+        sink_->write(output_);
+        unflushed_records_ += batch_.size();
+
+        return {batch_.size(), has_report};
+    }
+
+    void flush_if_due(uint64_t flush_request)
+    {
+        const FlushPolicy& policy = options_.flush_policy;
+        const bool is_requested = flush_request != completed_flush_requests_.load(std::memory_order_relaxed);
+
+        if (is_requested
+            || has_unflushed_severe_record_
+            || (policy.every_records > 0 && unflushed_records_ >= policy.every_records)
+            || (policy.every_interval.count() > 0 && unflushed_records_ > 0 && std::chrono::steady_clock::now() - last_flush_time_ >= policy.every_interval))
+        {
+            flush_sink();
+        }
+
+        if (is_requested)
+        {
+            completed_flush_requests_.store(flush_request);
+            completed_flush_requests_.notify_all();
+        }
+    }
+
+    void flush_sink()
+    {
+        if (unflushed_records_ > 0)
+        {
+            sink_->flush();
+            flush_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        unflushed_records_ = 0;
+        has_unflushed_severe_record_ = false;
+        last_flush_time_ = std::chrono::steady_clock::now();
+    }
+
+    const BinaryLog::Format& cached_format(uint32_t format_id)
+    {
+        if (format_id >= formats_.size())
+            formats_.resize(format_id + 1);
+
+        if (formats_[format_id].text.empty())
+            formats_[format_id] = BinaryLog::FormatRegistry::instance().get(format_id);
+
+        return formats_[format_id];
+    }
+
+    void append_binary_record(const BatchEntry& entry, const BinaryLog::Format& format, std::span<const std::byte> args)
+    {
+        if (!is_header_written_)
+        {
+            BinaryLog::append_file_header(output_);
+            is_header_written_ = true;
+        }
+
+        if (entry.format_id >= written_formats_.size())
+            written_formats_.resize(entry.format_id + 1);
+
+        if (!written_formats_[entry.format_id])
+        {
+            BinaryLog::append_format_definition(output_, entry.format_id, format);
+            written_formats_[entry.format_id] = true;
+        }
+
+        const auto timestamp_delta = static_cast<int64_t>(entry.timestamp_ns - last_timestamp_ns_);
+        BinaryLog::append_record(output_, entry.format_id, timestamp_delta, format, args);
+        last_timestamp_ns_ = entry.timestamp_ns;
+    }
+
+    void remove_buffer(const std::shared_ptr<ThreadBuffer>& buffer)
+    {
+        std::lock_guard lk{buffers_mtx_};
+        dropped_by_finished_threads_ += buffer->dropped.load(std::memory_order_relaxed);
+        suppressed_by_finished_threads_ += buffer->suppressed.load(std::memory_order_relaxed);
+        std::erase(buffers_, buffer);
+    }
+
+    // returns true when a report has been logged
+    bool report_dropped()
+    {
+        const uint64_t dropped = dropped_count();
+        if (dropped == reported_dropped_)
+            return false;
+
+        // reports bypass min_severity - otherwise the counts would be lost
+        log_unfiltered<"[logger] {} messages dropped - buffer full">(Severity::warning, dropped - reported_dropped_);
+        reported_dropped_ = dropped;
+        return true;
+    }
+
+    bool report_suppressed()
+    {
+        const uint64_t suppressed = suppressed_count();
+        if (suppressed == reported_suppressed_)
+            return false;
+
+        log_unfiltered<"[logger] {} messages suppressed by sampling or rate limits">(Severity::info, suppressed - reported_suppressed_);
+        reported_suppressed_ = suppressed;
+        return true;
+    }
+};
+
+#endif // ASYNC_LOGGER_HPP
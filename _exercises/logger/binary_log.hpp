@@ -0,0 +1,516 @@
+#ifndef BINARY_LOG_HPP
+#define BINARY_LOG_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Structured logging with deferred formatting.
+//
+// A call site is identified by a format id registered once for its format string and argument types.
+// On the hot path the producer only copies raw argument bytes (no text formatting, no allocation).
+// Records are formatted later - on the writer thread (text output) or offline by log-decoder
+// reading the binary file.
+namespace BinaryLog
+{
+    enum class ArgType : uint8_t
+    {
+        int64,
+        uint64,
+        float64,
+        boolean,
+        character,
+        string
+    };
+
+    template <typename T>
+    constexpr ArgType arg_type_of()
+    {
+        using TArg = std::remove_cvref_t<T>;
+
+        if constexpr (std::is_same_v<TArg, bool>)
+            return ArgType::boolean;
+        else if constexpr (std::is_same_v<TArg, char>)
+            return ArgType::character;
+        else if constexpr (std::is_integral_v<TArg> && std::is_signed_v<TArg>)
+            return ArgType::int64;
+        else if constexpr (std::is_integral_v<TArg>)
+            return ArgType::uint64;
+        else if constexpr (std::is_floating_point_v<TArg>)
+            return ArgType::float64;
+        else if constexpr (std::is_convertible_v<const TArg&, std::string_view>)
+            return ArgType::string;
+        else
+            static_assert(sizeof(TArg) == 0, "unsupported type of log argument");
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    // raw encoding of arguments - used in producer buffers (memcpy only)
+
+    template <typename T>
+    size_t raw_size(const T& arg)
+    {
+        constexpr ArgType type = arg_type_of<T>();
+
+        if constexpr (type == ArgType::boolean || type == ArgType::character)
+            return 1;
+        else if constexpr (type == ArgType::string)
+            return sizeof(uint32_t) + std::string_view{arg}.size();
+        else
+            return 8;
+    }
+
+    template <typename T>
+    std::byte* encode_raw(std::byte* dest, const T& arg)
+    {
+        constexpr ArgType type = arg_type_of<T>();
+
+        if constexpr (type == ArgType::string)
+        {
+            const std::string_view text{arg};
+            const auto size = static_cast<uint32_t>(text.size());
+            std::memcpy(dest, &size, sizeof(size));
+            std::memcpy(dest + sizeof(size), text.data(), text.size());
+            return dest + sizeof(size) + text.size();
+        }
+        else
+        {
+            using TRaw = std::conditional_t<type == ArgType::int64, int64_t,
+                std::conditional_t<type == ArgType::uint64, uint64_t,
+                    std::conditional_t<type == ArgType::float64, double, std::remove_cvref_t<T>>>>;
+
+            const TRaw value = static_cast<TRaw>(arg);
+            std::memcpy(dest, &value, sizeof(value));
+            return dest + sizeof(value);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    // format strings
+
+    template <size_t N>
+    struct FormatString
+    {
+        char value[N]{};
+
+        constexpr FormatString(const char (&text)[N])
+        {
+            std::copy_n(text, N, value);
+        }
+
+        constexpr std::string_view view() const
+        {
+            return {value, N - 1};
+        }
+
+        constexpr size_t placeholders_count() const
+        {
+            size_t count = 0;
+            for (size_t i = 0; i + 1 < N - 1; ++i)
+            {
+                if (value[i] == '{' && value[i + 1] == '{')
+                    ++i;
+                else if (value[i] == '{' && value[i + 1] == '}')
+                    ++count, ++i;
+            }
+            return count;
+        }
+    };
+
+    struct Format
+    {
+        std::string text;
+        std::vector<ArgType> arg_types;
+    };
+
+    // process-wide dictionary: format id -> format string + argument types
+    class FormatRegistry
+    {
+    public:
+        static constexpr uint32_t plain_text_id = 1; // "{}" with one string argument - used by log(string_view)
+
+        static FormatRegistry& instance()
+        {
+            static FormatRegistry registry;
+            return registry;
+        }
+
+        uint32_t add(std::string_view text, std::vector<ArgType> arg_types)
+        {
+            std::lock_guard lk{mtx_};
+
+            std::string key{text};
+            for (auto type : arg_types)
+                key.push_back(static_cast<char>('0' + static_cast<int>(type)));
+
+            auto [it, inserted] = ids_.try_emplace(std::move(key), static_cast<uint32_t>(formats_.size()));
+            if (inserted)
+                formats_.push_back(Format{std::string{text}, std::move(arg_types)});
+
+            return it->second;
+        }
+
+        Format get(uint32_t id) const
+        {
+            std::lock_guard lk{mtx_};
+            return formats_.at(id);
+        }
+
+    private:
+        mutable std::mutex mtx_;
+        std::vector<Format> formats_;
+        std::map<std::string, uint32_t> ids_;
+
+        FormatRegistry()
+        {
+            formats_.emplace_back();                                                      // id 0 - definition marker in files
+            formats_.push_back(Format{"{}", {ArgType::string}});                          // plain_text_id
+            ids_.emplace("{}" + std::string(1, '0' + static_cast<int>(ArgType::string)), plain_text_id);
+        }
+    };
+
+    // registered once per format string and argument types
+    template <FormatString Fmt, typename... TArgs>
+    uint32_t format_id()
+    {
+        static const uint32_t id = FormatRegistry::instance().add(Fmt.view(), {arg_type_of<TArgs>()...});
+        return id;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    // formatting of raw arguments
+
+    class RawArgReader
+    {
+    public:
+        explicit RawArgReader(std::span<const std::byte> data)
+            : data_{data}
+        {
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            take(&value, sizeof(value));
+            return value;
+        }
+
+        std::string_view read_string()
+        {
+            const auto size = read<uint32_t>();
+            if (size > data_.size())
+                throw std::runtime_error("corrupted log record");
+
+            const std::string_view text{reinterpret_cast<const char*>(data_.data()), size};
+            data_ = data_.subspan(size);
+            return text;
+        }
+
+    private:
+        std::span<const std::byte> data_;
+
+        void take(void* dest, size_t size)
+        {
+            if (size > data_.size())
+                throw std::runtime_error("corrupted log record");
+
+            std::memcpy(dest, data_.data(), size);
+            data_ = data_.subspan(size);
+        }
+    };
+
+    inline void append_arg(std::string& out, ArgType type, RawArgReader& reader)
+    {
+        char buffer[32];
+        std::to_chars_result result{buffer, {}};
+
+        switch (type)
+        {
+        case ArgType::int64:
+            result = std::to_chars(buffer, std::end(buffer), reader.read<int64_t>());
+            break;
+        case ArgType::uint64:
+            result = std::to_chars(buffer, std::end(buffer), reader.read<uint64_t>());
+            break;
+        case ArgType::float64:
+            result = std::to_chars(buffer, std::end(buffer), reader.read<double>());
+            break;
+        case ArgType::boolean:
+            out.append(reader.read<bool>() ? "true" : "false");
+            return;
+        case ArgType::character:
+            out.push_back(reader.read<char>());
+            return;
+        case ArgType::string:
+            out.append(reader.read_string());
+            return;
+        }
+
+        out.append(buffer, result.ptr);
+    }
+
+    // replaces consecutive {} with arguments ({{ and }} are escaped braces)
+    inline void format_message(std::string& out, const Format& format, std::span<const std::byte> raw_args)
+    {
+        RawArgReader reader{raw_args};
+        size_t arg_index = 0;
+        const std::string_view text = format.text;
+
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (i + 1 < text.size() && ((text[i] == '{' && text[i + 1] == '{') || (text[i] == '}' && text[i + 1] == '}')))
+            {
+                out.push_back(text[i++]);
+            }
+            else if (i + 1 < text.size() && text[i] == '{' && text[i + 1] == '}' && arg_index < format.arg_types.size())
+            {
+                append_arg(out, format.arg_types[arg_index++], reader);
+                ++i;
+            }
+            else
+            {
+                out.push_back(text[i]);
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    // binary file format
+    //
+    //   file:       magic "BLOG" | uint32 version | entries...
+    //   entry:      varint id, where id == 0 starts a format definition, otherwise a record
+    //   definition: varint format_id | varint length | text | varint args_count | arg types (1 byte each)
+    //   record:     zigzag varint timestamp delta [ns] | arguments in compact form
+    //               (integers as varints, strings as varint length + bytes)
+
+    constexpr char file_magic[4] = {'B', 'L', 'O', 'G'};
+    constexpr uint32_t file_version = 1;
+
+    inline void append_varint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    inline uint64_t zigzag(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    inline int64_t unzigzag(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    inline void append_file_header(std::string& out)
+    {
+        out.append(file_magic, sizeof(file_magic));
+        out.append(reinterpret_cast<const char*>(&file_version), sizeof(file_version));
+    }
+
+    inline void append_format_definition(std::string& out, uint32_t id, const Format& format)
+    {
+        append_varint(out, 0);
+        append_varint(out, id);
+        append_varint(out, format.text.size());
+        out.append(format.text);
+        append_varint(out, format.arg_types.size());
+        for (auto type : format.arg_types)
+            out.push_back(static_cast<char>(type));
+    }
+
+    inline void append_record(std::string& out, uint32_t id, int64_t timestamp_delta, const Format& format, std::span<const std::byte> raw_args)
+    {
+        append_varint(out, id);
+        append_varint(out, zigzag(timestamp_delta));
+
+        RawArgReader reader{raw_args};
+        for (auto type : format.arg_types)
+        {
+            switch (type)
+            {
+            case ArgType::int64:
+                append_varint(out, zigzag(reader.read<int64_t>()));
+                break;
+            case ArgType::uint64:
+                append_varint(out, reader.read<uint64_t>());
+                break;
+            case ArgType::float64:
+            {
+                const auto value = reader.read<double>();
+                out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+                break;
+            }
+            case ArgType::boolean:
+                out.push_back(static_cast<char>(reader.read<bool>()));
+                break;
+            case ArgType::character:
+                out.push_back(reader.read<char>());
+                break;
+            case ArgType::string:
+            {
+                const auto text = reader.read_string();
+                append_varint(out, text.size());
+                out.append(text);
+                break;
+            }
+            }
+        }
+    }
+
+    // reads a binary log file and formats its records as text lines
+    class Decoder
+    {
+    public:
+        explicit Decoder(std::string_view data)
+            : data_{data}
+        {
+            if (data_.size() < sizeof(file_magic) + sizeof(file_version) || data_.substr(0, sizeof(file_magic)) != std::string_view{file_magic, sizeof(file_magic)})
+                throw std::runtime_error("not a binary log file");
+
+            data_.remove_prefix(sizeof(file_magic) + sizeof(file_version));
+        }
+
+        // appends next message + '\n' to out; returns false at the end of data
+        bool next(std::string& out)
+        {
+            while (!data_.empty())
+            {
+                const auto id = read_varint();
+
+                if (id == 0)
+                {
+                    read_definition();
+                    continue;
+                }
+
+                if (id >= formats_.size() || formats_[id].text.empty())
+                    throw std::runtime_error("log record with unknown format id");
+
+                timestamp_ns_ += unzigzag(read_varint());
+                const Format& format = formats_[id];
+
+                raw_args_.clear();
+                for (auto type : format.arg_types)
+                    read_arg_as_raw(type);
+
+                format_message(out, format, raw_args_);
+                out.push_back('\n');
+                return true;
+            }
+
+            return false;
+        }
+
+        // steady-clock timestamp of the last decoded record
+        int64_t timestamp_ns() const
+        {
+            return timestamp_ns_;
+        }
+
+    private:
+        std::string_view data_;
+        std::vector<Format> formats_;
+        std::vector<std::byte> raw_args_;
+        int64_t timestamp_ns_ = 0;
+
+        uint64_t read_varint()
+        {
+            uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                if (data_.empty())
+                    throw std::runtime_error("truncated binary log");
+
+                const auto byte = static_cast<uint8_t>(data_.front());
+                data_.remove_prefix(1);
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+            throw std::runtime_error("corrupted varint in binary log");
+        }
+
+        std::string_view read_bytes(size_t size)
+        {
+            if (size > data_.size())
+                throw std::runtime_error("truncated binary log");
+
+            const auto bytes = data_.substr(0, size);
+            data_.remove_prefix(size);
+            return bytes;
+        }
+
+        void read_definition()
+        {
+            const auto id = read_varint();
+            Format format;
+            format.text = read_bytes(read_varint());
+            const auto args_count = read_varint();
+            for (uint64_t i = 0; i < args_count; ++i)
+                format.arg_types.push_back(static_cast<ArgType>(read_bytes(1)[0]));
+
+            if (id >= formats_.size())
+                formats_.resize(id + 1);
+            formats_[id] = std::move(format);
+        }
+
+        template <typename T>
+        void append_raw(const T& value)
+        {
+            const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+            raw_args_.insert(raw_args_.end(), bytes, bytes + sizeof(value));
+        }
+
+        void read_arg_as_raw(ArgType type)
+        {
+            switch (type)
+            {
+            case ArgType::int64:
+                append_raw(unzigzag(read_varint()));
+                break;
+            case ArgType::uint64:
+                append_raw(read_varint());
+                break;
+            case ArgType::float64:
+            {
+                double value;
+                std::memcpy(&value, read_bytes(sizeof(value)).data(), sizeof(value));
+                append_raw(value);
+                break;
+            }
+            case ArgType::boolean:
+                append_raw(static_cast<bool>(read_bytes(1)[0]));
+                break;
+            case ArgType::character:
+                append_raw(read_bytes(1)[0]);
+                break;
+            case ArgType::string:
+            {
+                const auto text = read_bytes(read_varint());
+                append_raw(static_cast<uint32_t>(text.size()));
+                const auto* bytes = reinterpret_cast<const std::byte*>(text.data());
+                raw_args_.insert(raw_args_.end(), bytes, bytes + text.size());
+                break;
+            }
+            }
+        }
+    };
+} // namespace BinaryLog
+
+#endif // BINARY_LOG_HPP
@@ -0,0 +1,67 @@
+#include "binary_log.hpp"
+#include "log_sinks.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+// returns contents of a log file - for segments of MmapSegmentSink only the committed data
+std::string read_log_data(const std::string& path)
+{
+    std::ifstream fin{path, std::ios::binary};
+    if (!fin)
+        throw std::runtime_error("Cannot open " + path);
+
+    std::string data{std::istreambuf_iterator<char>{fin}, std::istreambuf_iterator<char>{}};
+
+#if defined(__unix__)
+    if (data.size() >= sizeof(LogSegmentHeader) && std::memcmp(data.data(), LogSegmentHeader::magic_value, 4) == 0)
+    {
+        LogSegmentHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        return data.substr(sizeof(header), header.committed_length);
+    }
+#endif
+
+    return data;
+}
+
+// Prints a log written by AsyncLogger as text lines.
+// Binary logs (LogOutput::binary) are decoded; segments of MmapSegmentSink are concatenated in given order.
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <log file or segments...>" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::string data;
+        for (int i = 1; i < argc; ++i)
+            data += read_log_data(argv[i]);
+
+        if (data.compare(0, sizeof(BinaryLog::file_magic), BinaryLog::file_magic, sizeof(BinaryLog::file_magic)) != 0)
+        {
+            std::cout << data; // text log
+            return 0;
+        }
+
+        BinaryLog::Decoder decoder{data};
+        std::string line;
+
+        while (decoder.next(line))
+        {
+            std::cout << line;
+            line.clear();
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
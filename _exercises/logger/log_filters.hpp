@@ -0,0 +1,124 @@
+#ifndef LOG_FILTERS_HPP
+#define LOG_FILTERS_HPP
+
+#include "async_logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+// Records below this severity are removed at compile time by the LOG_* macros (0 - debug ... 5 - off)
+#ifndef LOGGER_MIN_SEVERITY
+#define LOGGER_MIN_SEVERITY 0
+#endif
+
+// Passes 1 in N calls of a call site - counted separately by every thread, so no state is shared
+class LogSampler
+{
+public:
+    explicit LogSampler(uint64_t n)
+        : n_{std::max<uint64_t>(n, 1)}
+    {
+    }
+
+    bool try_pass()
+    {
+        return calls_++ % n_ == 0;
+    }
+
+private:
+    const uint64_t n_;
+    uint64_t calls_ = 0;
+};
+
+// Token bucket shared by all threads calling a call site: rate messages per second, bursts up to burst messages.
+//
+// Implemented as GCRA - the whole state is the theoretical arrival time of the next message,
+// so a passed message costs one CAS and a suppressed one only a load (besides reading the clock).
+class LogRateLimiter
+{
+public:
+    LogRateLimiter(double rate_per_second, double burst = 1.0)
+        : emission_interval_ns_{emission_interval_ns(rate_per_second)}
+        , burst_tolerance_ns_{static_cast<int64_t>(emission_interval_ns_ * (std::max(burst, 1.0) - 1.0))}
+    {
+    }
+
+    bool try_pass()
+    {
+        const int64_t now = now_ns();
+        int64_t arrival = next_arrival_ns_.load(std::memory_order_relaxed);
+
+        do
+        {
+            if (now < arrival - burst_tolerance_ns_)
+                return false;
+        } while (!next_arrival_ns_.compare_exchange_weak(arrival, std::max(arrival, now) + emission_interval_ns_, std::memory_order_relaxed));
+
+        return true;
+    }
+
+private:
+    const int64_t emission_interval_ns_;
+    const int64_t burst_tolerance_ns_;
+    std::atomic<int64_t> next_arrival_ns_{0};
+
+    static int64_t emission_interval_ns(double rate_per_second)
+    {
+        if (!(rate_per_second > 0.0)) // also NaN
+            throw std::invalid_argument("LogRateLimiter: rate_per_second must be positive");
+        return static_cast<int64_t>(std::min(1e9 / rate_per_second, 1e18)); // a rate close to 0 passes the first message only
+    }
+
+    static int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// LOG(logger, Severity::info, "format {}", args...)
+// Arguments are not evaluated when the record is disabled at compile time or by logger.min_severity().
+#define LOG(logger, severity, format, ...)                                                      \
+    do                                                                                          \
+    {                                                                                           \
+        if constexpr ((severity) >= static_cast<Severity>(LOGGER_MIN_SEVERITY))                 \
+        {                                                                                       \
+            if ((logger).is_enabled(severity))                                                  \
+                (logger).template log<format>((severity)__VA_OPT__(, ) __VA_ARGS__);            \
+        }                                                                                       \
+    } while (false)
+
+// logs through a call-site filter (LogSampler or LogRateLimiter) - suppressed calls are counted by the logger
+#define LOG_FILTERED(logger, severity, filter_declaration, format, ...)                         \
+    do                                                                                          \
+    {                                                                                           \
+        if constexpr ((severity) >= static_cast<Severity>(LOGGER_MIN_SEVERITY))                 \
+        {                                                                                       \
+            if ((logger).is_enabled(severity))                                                  \
+            {                                                                                   \
+                filter_declaration;                                                             \
+                if (log_filter_.try_pass())                                                     \
+                    (logger).template log<format>((severity)__VA_OPT__(, ) __VA_ARGS__);        \
+                else                                                                            \
+                    (logger).count_suppressed(1);                                               \
+            }                                                                                   \
+        }                                                                                       \
+    } while (false)
+
+// LOG_EVERY_N(logger, Severity::debug, 100, "format {}", args...) - 1 in n calls of every thread
+#define LOG_EVERY_N(logger, severity, n, format, ...) \
+    LOG_FILTERED(logger, severity, thread_local LogSampler log_filter_{n}, format __VA_OPT__(, ) __VA_ARGS__)
+
+// LOG_RATE_LIMITED(logger, Severity::warning, 10.0, "format {}", args...) - at most rate_per_second messages per second
+#define LOG_RATE_LIMITED(logger, severity, rate_per_second, format, ...) \
+    LOG_FILTERED(logger, severity, static LogRateLimiter log_filter_{rate_per_second}, format __VA_OPT__(, ) __VA_ARGS__)
+
+#define LOG_DEBUG(logger, format, ...) LOG(logger, Severity::debug, format __VA_OPT__(, ) __VA_ARGS__)
+#define LOG_INFO(logger, format, ...) LOG(logger, Severity::info, format __VA_OPT__(, ) __VA_ARGS__)
+#define LOG_WARNING(logger, format, ...) LOG(logger, Severity::warning, format __VA_OPT__(, ) __VA_ARGS__)
+#define LOG_ERROR(logger, format, ...) LOG(logger, Severity::error, format __VA_OPT__(, ) __VA_ARGS__)
+#define LOG_CRITICAL(logger, format, ...) LOG(logger, Severity::critical, format __VA_OPT__(, ) __VA_ARGS__)
+
+#endif // LOG_FILTERS_HPP
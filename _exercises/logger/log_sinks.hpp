@@ -0,0 +1,213 @@
+#ifndef LOG_SINKS_HPP
+#define LOG_SINKS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Output backend of AsyncLogger - called only from the logger's writer thread
+class LogSink
+{
+public:
+    virtual ~LogSink() = default;
+
+    virtual void write(std::string_view data) = 0;
+
+    // hands written data over to the operating system - survives a crash of the process, not of the machine (no fsync)
+    virtual void flush() = 0;
+
+    // called before every batch - returns true when the sink has switched to a new file
+    // (binary output starts the new file with its own header and format definitions)
+    virtual bool roll_if_due()
+    {
+        return false;
+    }
+};
+
+class FileSink : public LogSink
+{
+    std::ofstream fout_;
+
+public:
+    explicit FileSink(const std::string& file_name)
+        : fout_{file_name, std::ios::binary}
+    {
+        if (!fout_)
+            throw std::runtime_error("Cannot open log file: " + file_name);
+    }
+
+    void write(std::string_view data) override
+    {
+        fout_.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    void flush() override
+    {
+        fout_.flush();
+    }
+};
+
+#if defined(__unix__)
+// Header at the beginning of every segment file of MmapSegmentSink
+struct LogSegmentHeader
+{
+    static constexpr char magic_value[4] = {'L', 'S', 'E', 'G'};
+
+    char magic[4];
+    uint32_t version;
+    uint64_t index;
+    uint64_t committed_length; // bytes of data following the header - updated after every write
+    char reserved[40];
+};
+
+static_assert(sizeof(LogSegmentHeader) == 64);
+
+// Writes log data straight into preallocated, memory-mapped segment files: <base_path>.000000, <base_path>.000001, ...
+//
+// There is no stream buffer and no write() syscall - data is copied into the page cache by memcpy.
+// The committed length in the header is published after every write, so after a crash of the process
+// a segment holds exactly the data written before the last completed write().
+// Segments form one continuous stream - a batch is moved to the next segment when it does not fit,
+// and only batches larger than a whole segment are split.
+class MmapSegmentSink : public LogSink
+{
+public:
+    explicit MmapSegmentSink(std::string base_path, size_t segment_size = 64 * 1024 * 1024)
+        : base_path_{std::move(base_path)}
+        , segment_size_{std::max(segment_size, sizeof(LogSegmentHeader) + 4096)}
+    {
+        open_segment();
+    }
+
+    MmapSegmentSink(const MmapSegmentSink&) = delete;
+    MmapSegmentSink& operator=(const MmapSegmentSink&) = delete;
+
+    ~MmapSegmentSink() override
+    {
+        close_segment();
+    }
+
+    void write(std::string_view data) override
+    {
+        if (!mapping_)
+            open_segment(); // the previous roll has failed
+
+        if (data.size() > free_space() && used_ > 0)
+            roll_segment();
+
+        while (!data.empty())
+        {
+            const size_t chunk = std::min(data.size(), free_space());
+            std::memcpy(data_ + used_, data.data(), chunk);
+            used_ += chunk;
+            data.remove_prefix(chunk);
+
+            std::atomic_ref<uint64_t>{header_->committed_length}.store(used_, std::memory_order_release);
+
+            if (!data.empty())
+                roll_segment();
+        }
+    }
+
+    // Only starts write-back of dirty pages (MS_ASYNC) and returns - the data is not durable against a power loss
+    // when flush() returns. Durability against a crash of the process does not need it.
+    void flush() override
+    {
+        if (mapping_)
+            msync(mapping_, sizeof(LogSegmentHeader) + used_, MS_ASYNC);
+    }
+
+    static std::string segment_path(const std::string& base_path, uint64_t index)
+    {
+        std::string suffix = std::to_string(index);
+        return base_path + "." + std::string(6 - std::min<size_t>(suffix.size(), 6), '0') + suffix;
+    }
+
+private:
+    const std::string base_path_;
+    const size_t segment_size_;
+    uint64_t index_ = 0;
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    LogSegmentHeader* header_ = nullptr;
+    char* data_ = nullptr;
+    size_t used_ = 0;
+
+    size_t free_space() const
+    {
+        return segment_size_ - sizeof(LogSegmentHeader) - used_;
+    }
+
+    void open_segment()
+    {
+        const std::string path = segment_path(base_path_, index_);
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ == -1)
+            throw std::system_error(errno, std::generic_category(), "Cannot open log segment " + path);
+
+        if (const int error = posix_fallocate(fd_, 0, static_cast<off_t>(segment_size_)); error != 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+            throw std::system_error(error, std::generic_category(), "Cannot preallocate log segment " + path);
+        }
+
+        void* mapping = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (mapping == MAP_FAILED)
+        {
+            ::close(fd_);
+            fd_ = -1;
+            throw std::system_error(errno, std::generic_category(), "Cannot map log segment " + path);
+        }
+
+        mapping_ = mapping;
+        header_ = static_cast<LogSegmentHeader*>(mapping_);
+        std::memcpy(header_->magic, LogSegmentHeader::magic_value, sizeof(header_->magic));
+        header_->version = 1;
+        header_->index = index_;
+        header_->committed_length = 0;
+
+        data_ = static_cast<char*>(mapping_) + sizeof(LogSegmentHeader);
+        used_ = 0;
+    }
+
+    // safe to call again - the destructor runs it also after open_segment() of a roll has failed
+    void close_segment()
+    {
+        if (!mapping_)
+            return;
+
+        munmap(mapping_, segment_size_);
+        [[maybe_unused]] const int result = ftruncate(fd_, static_cast<off_t>(sizeof(LogSegmentHeader) + used_)); // unused preallocated space
+        ::close(fd_);
+
+        fd_ = -1;
+        mapping_ = nullptr;
+        header_ = nullptr;
+        data_ = nullptr;
+        used_ = 0;
+    }
+
+    void roll_segment()
+    {
+        close_segment();
+        ++index_;
+        open_segment();
+    }
+};
+#endif
+
+#endif // LOG_SINKS_HPP
@@ -0,0 +1,354 @@
+#include "async_logger.hpp"
+#include "log_filters.hpp"
+#include "log_sinks.hpp"
+#include "rotating_file_sink.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    // synchronous baseline - Logger from logger_ex.cpp made thread-safe with a mutex
+    class SyncLogger
+    {
+        mutex mtx_;
+        ofstream fout_;
+
+    public:
+        explicit SyncLogger(const string& file_name)
+            : fout_{file_name}
+        {
+        }
+
+        void log(string_view message)
+        {
+            lock_guard lk{mtx_};
+            fout_ << message << endl;
+        }
+    };
+
+    struct Backend
+    {
+        string name;
+        function<void(const fs::path& dir, const function<void(const function<void(string_view)>&)>& run)> with_logger;
+    };
+
+    template <typename TLogger>
+    void run_with(TLogger& logger, const function<void(const function<void(string_view)>&)>& run)
+    {
+        run([&logger](string_view message) { logger.log(message); });
+    }
+
+    const vector<Backend>& backends()
+    {
+        static const vector<Backend> backends = {
+            {"sync (mutex + endl)", [](const fs::path& dir, const auto& run) {
+                 SyncLogger logger{(dir / "sync.log").string()};
+                 run_with(logger, run);
+             }},
+            {"async text", [](const fs::path& dir, const auto& run) {
+                 AsyncLogger logger{(dir / "async.log").string()};
+                 run_with(logger, run);
+             }},
+            {"async binary", [](const fs::path& dir, const auto& run) {
+                 AsyncLogger logger{(dir / "async.blog").string(), {.output = LogOutput::binary}};
+                 run_with(logger, run);
+             }},
+#if defined(__unix__)
+            {"async mmap segments", [](const fs::path& dir, const auto& run) {
+                 AsyncLogger logger{make_unique<MmapSegmentSink>((dir / "mmap.log").string())};
+                 run_with(logger, run);
+             }},
+#endif
+            {"async rotating 4MB", [](const fs::path& dir, const auto& run) {
+                 AsyncLogger logger{make_unique<RotatingFileSink>((dir / "rotating.log").string(), RotationOptions{.max_file_size = 4 * 1024 * 1024, .max_rotated_files = 1000})};
+                 run_with(logger, run);
+             }},
+        };
+
+        return backends;
+    }
+
+    struct SweepResult
+    {
+        double msgs_per_second;
+        uint64_t p50_ns;
+        uint64_t p99_ns;
+        uint64_t p999_ns;
+        uint64_t bytes_written;
+    };
+
+    uint64_t directory_size(const fs::path& dir)
+    {
+        uint64_t size = 0;
+        for (const auto& entry : fs::recursive_directory_iterator{dir})
+        {
+            if (entry.is_regular_file())
+                size += entry.file_size();
+        }
+        return size;
+    }
+
+    // throughput includes draining of the buffers - the logger is destroyed before the clock stops
+    SweepResult run_sweep_point(const Backend& backend, const fs::path& dir, int threads_count, size_t messages_per_thread, const string& message)
+    {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+
+        vector<vector<uint32_t>> latencies(threads_count, vector<uint32_t>(messages_per_thread));
+
+        const auto start = chrono::steady_clock::now();
+
+        backend.with_logger(dir, [&](const function<void(string_view)>& log) {
+            latch start_line{threads_count};
+            vector<jthread> threads;
+
+            for (int t = 0; t < threads_count; ++t)
+                threads.emplace_back([&, t] {
+                    auto& thread_latencies = latencies[t];
+                    start_line.arrive_and_wait();
+
+                    for (size_t i = 0; i < messages_per_thread; ++i)
+                    {
+                        const auto call_start = chrono::steady_clock::now();
+                        log(message);
+                        const auto call_ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - call_start).count();
+                        thread_latencies[i] = static_cast<uint32_t>(min<int64_t>(call_ns, UINT32_MAX));
+                    }
+                });
+        });
+
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        vector<uint32_t> all;
+        all.reserve(threads_count * messages_per_thread);
+        for (const auto& thread_latencies : latencies)
+            all.insert(all.end(), thread_latencies.begin(), thread_latencies.end());
+        sort(all.begin(), all.end());
+
+        auto percentile = [&all](double p) { return static_cast<uint64_t>(all[min(all.size() - 1, static_cast<size_t>(p * static_cast<double>(all.size())))]); };
+
+        SweepResult result{static_cast<double>(all.size()) / elapsed.count(), percentile(0.5), percentile(0.99), percentile(0.999), directory_size(dir)};
+        fs::remove_all(dir);
+        return result;
+    }
+
+    // every backend for every combination of producer threads and message size
+    void benchmark_sweep(size_t messages_per_thread, int max_threads)
+    {
+        const fs::path dir = fs::temp_directory_path() / "logger_bench" / "sweep";
+
+        cout << "Sweep - " << messages_per_thread << " messages per thread, latency of a log() call:\n";
+        cout << left << setw(22) << "backend" << right << setw(8) << "threads" << setw(8) << "size" << setw(14) << "msgs/s"
+             << setw(10) << "p50 ns" << setw(10) << "p99 ns" << setw(10) << "p99.9 ns" << setw(12) << "MB written" << '\n';
+
+        for (size_t message_size : {16, 128, 1024})
+        {
+            const string message(message_size, 'x');
+
+            for (int threads_count = 1; threads_count <= max_threads; threads_count *= 2)
+            {
+                for (const auto& backend : backends())
+                {
+                    const SweepResult r = run_sweep_point(backend, dir, threads_count, messages_per_thread, message);
+
+                    cout << left << setw(22) << backend.name << right << setw(8) << threads_count << setw(8) << message_size
+                         << setw(14) << fixed << setprecision(0) << r.msgs_per_second
+                         << setw(10) << r.p50_ns << setw(10) << r.p99_ns << setw(10) << r.p999_ns
+                         << setw(12) << setprecision(1) << static_cast<double>(r.bytes_written) / (1024.0 * 1024.0) << '\n';
+                }
+            }
+        }
+    }
+
+    // batch of text lines as built by the writer thread of AsyncLogger
+    string make_batch(size_t size)
+    {
+        string batch;
+        for (int i = 0; batch.size() < size; ++i)
+            batch += "2024-01-01 12:00:00.000000 [thread " + to_string(i % 8) + "] Log#" + to_string(i) + " - Event#" + to_string(i * 7) + '\n';
+        return batch;
+    }
+
+    // sustained write rate of a sink: one write() + flush() per batch, as in AsyncLogger::drain()
+    double sink_throughput_mb_s(LogSink& sink, const string& batch, size_t total_bytes)
+    {
+        const auto start = chrono::steady_clock::now();
+
+        for (size_t written = 0; written < total_bytes; written += batch.size())
+        {
+            sink.write(batch);
+            sink.flush();
+        }
+
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        return static_cast<double>(total_bytes) / (1024.0 * 1024.0) / elapsed.count();
+    }
+
+    void benchmark_sinks(size_t total_mb)
+    {
+        const fs::path dir = fs::temp_directory_path() / "logger_bench";
+        fs::create_directories(dir);
+
+        const size_t total_bytes = total_mb * 1024 * 1024;
+
+        struct SinkFactory
+        {
+            string name;
+            function<unique_ptr<LogSink>()> create;
+        };
+
+        const SinkFactory sinks[] = {
+            {"FileSink (ofstream)", [&dir] { return make_unique<FileSink>((dir / "file_sink.log").string()); }},
+#if defined(__unix__)
+            {"MmapSegmentSink 64MB", [&dir] { return make_unique<MmapSegmentSink>((dir / "mmap_sink.log").string()); }},
+            {"MmapSegmentSink 4MB", [&dir] { return make_unique<MmapSegmentSink>((dir / "mmap_sink_small.log").string(), 4 * 1024 * 1024); }},
+#endif
+        };
+
+        cout << "\nSinks - " << total_mb << " MB written in batches (write + flush per batch):\n";
+        cout << left << setw(24) << "sink" << right << setw(12) << "batch" << setw(12) << "MB/s" << '\n';
+
+        for (size_t batch_size : {4 * 1024, 64 * 1024, 1024 * 1024})
+        {
+            const string batch = make_batch(batch_size);
+
+            for (const auto& [name, create] : sinks)
+            {
+                double mb_s;
+                {
+                    auto sink = create();
+                    mb_s = sink_throughput_mb_s(*sink, batch, total_bytes);
+                }
+
+                cout << left << setw(24) << name << right << setw(12) << batch.size() << setw(12) << fixed << setprecision(1) << mb_s << '\n';
+            }
+        }
+
+        fs::remove_all(dir);
+    }
+
+    // throughput of AsyncLogger vs number of sink flushes - every flush hands data over to the OS,
+    // records written but not flushed yet are lost when the process crashes
+    void benchmark_flush_policies(size_t messages_per_thread, int threads_count)
+    {
+        const fs::path dir = fs::temp_directory_path() / "logger_bench";
+        fs::create_directories(dir);
+
+        struct Policy
+        {
+            string name;
+            FlushPolicy flush_policy;
+            bool has_explicit_flushes = false;
+        };
+
+        const Policy policies[] = {
+            {"every batch", {.every_records = 1}},
+            {"every 1000 records", {.every_records = 1000, .on_severity = Severity::off}},
+            {"every 10 ms", {.every_records = 0, .every_interval = chrono::milliseconds{10}, .on_severity = Severity::off}},
+            {"severity >= error", {.every_records = 0, .on_severity = Severity::error}},
+            {"explicit flush()", {.every_records = 0, .on_severity = Severity::off}, true},
+        };
+
+        cout << "\nFlush policies - " << threads_count << " threads x " << messages_per_thread << " messages (1 in 1000 is an error):\n";
+        cout << left << setw(22) << "policy" << right << setw(14) << "msgs/s" << setw(10) << "flushes" << setw(16) << "records/flush" << '\n';
+
+        for (const auto& [name, flush_policy, has_explicit_flushes] : policies)
+        {
+            const auto start = chrono::steady_clock::now();
+            uint64_t flushes;
+            {
+                AsyncLogger logger{(dir / "flush_policy.log").string(), {.flush_policy = flush_policy}};
+
+                vector<jthread> threads;
+                for (int t = 0; t < threads_count; ++t)
+                    threads.emplace_back([&logger, t, messages_per_thread, has_explicit_flushes] {
+                        for (size_t i = 0; i < messages_per_thread; ++i)
+                        {
+                            const Severity severity = i % 1000 == 999 ? Severity::error : Severity::info;
+                            logger.log<"Thread#{} - Event#{} - value: {}">(severity, t, i, i * 0.5);
+
+                            if (has_explicit_flushes && i % 10'000 == 9'999)
+                                logger.flush();
+                        }
+                    });
+                threads.clear();
+
+                logger.flush();
+                flushes = logger.flush_count();
+            }
+            const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+            const double total = static_cast<double>(messages_per_thread) * threads_count;
+            cout << left << setw(22) << name << right << setw(14) << fixed << setprecision(0) << total / elapsed.count()
+                 << setw(10) << flushes << setw(16) << setprecision(1) << total / static_cast<double>(max<uint64_t>(flushes, 1)) << '\n';
+        }
+
+        fs::remove_all(dir);
+    }
+
+    template <typename TLogCall>
+    double ns_per_call(size_t calls, TLogCall log_call)
+    {
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < calls; ++i)
+            log_call(i);
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        return elapsed.count() / static_cast<double>(calls);
+    }
+
+    // cost of a call site that is filtered out on the calling thread
+    void benchmark_filtering(size_t calls)
+    {
+        const fs::path dir = fs::temp_directory_path() / "logger_bench";
+        fs::create_directories(dir);
+
+        cout << "\nFiltering - " << calls << " calls on one thread:\n";
+        cout << left << setw(34) << "call site" << right << setw(12) << "ns/call" << '\n';
+
+        auto report = [](const string& name, double ns) {
+            cout << left << setw(34) << name << right << setw(12) << fixed << setprecision(2) << ns << '\n';
+        };
+
+        AsyncLogger logger{(dir / "filtering.log").string(), {.overflow_policy = OverflowPolicy::drop, .min_severity = Severity::info}};
+
+        report("debug - below runtime level", ns_per_call(calls, [&](size_t i) { LOG_DEBUG(logger, "Event#{} - value: {}", i, i * 0.5); }));
+        report("info - logged", ns_per_call(calls, [&](size_t i) { LOG_INFO(logger, "Event#{} - value: {}", i, i * 0.5); }));
+        report("info - 1 in 100", ns_per_call(calls, [&](size_t i) { LOG_EVERY_N(logger, Severity::info, 100, "Event#{} - value: {}", i, i * 0.5); }));
+        report("info - rate limit 1000/s", ns_per_call(calls, [&](size_t i) { LOG_RATE_LIMITED(logger, Severity::info, 1000.0, "Event#{} - value: {}", i, i * 0.5); }));
+
+        logger.flush();
+        cout << "suppressed messages reported by the logger: " << logger.suppressed_count() << ", dropped (buffer full): " << logger.dropped_count() << '\n';
+    }
+}
+
+// Usage: logger-bench [messages per thread] [max threads] [total MB written to each sink]
+int main(int argc, char* argv[])
+{
+    const size_t messages_per_thread = argc > 1 ? strtoull(argv[1], nullptr, 10) : 50'000;
+    const int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+    const size_t total_mb = argc > 3 ? strtoull(argv[3], nullptr, 10) : 256;
+    const int threads_count = max(max_threads / 2, 1);
+
+    benchmark_sweep(messages_per_thread, max_threads);
+    benchmark_sinks(total_mb);
+    benchmark_flush_policies(messages_per_thread, threads_count);
+    benchmark_filtering(10'000'000);
+}
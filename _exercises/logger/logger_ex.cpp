@@ -1,4 +1,8 @@
+#include "async_logger.hpp"
+#include "rotating_file_sink.hpp"
+
 #include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -35,25 +39,55 @@ namespace Before
     };
 }
 
-using namespace Before;
-
-void run(Logger& logger, int id)
+template <typename TLogger>
+void run(TLogger& logger, int id)
 {
     for (int i = 0; i < 1000; ++i)
         logger.log("Log#" + to_string(id) + " - Event#" + to_string(i));
 }
 
+// formatting is deferred - only format id and raw values of id & i are copied on the calling thread
+void run_structured(AsyncLogger& logger, int id)
+{
+    for (int i = 0; i < 1000; ++i)
+        logger.log<"Log#{} - Event#{}">(id, i);
+}
+
 int main()
 {
-    /*
-     * TODO: Write a Logger class which is thread-safe
-     */
+    {
+        // thread-safe logger: log() appends to a per-thread buffer, file is written by a background thread
+        AsyncLogger log("data.log");
+
+        thread thd1(&run<AsyncLogger>, ref(log), 1);
+        thread thd2(&run<AsyncLogger>, ref(log), 2);
+
+        thd1.join();
+        thd2.join();
+    }
+
+    {
+        // binary records - read with: log-decoder data.blog
+        AsyncLogger log("data.blog", {.output = LogOutput::binary});
+
+        thread thd1(&run_structured, ref(log), 1);
+        thread thd2(&run_structured, ref(log), 2);
+
+        thd1.join();
+        thd2.join();
+    }
+
+    {
+        // rotation by size - compression and deletion of old files are done by a background thread
+        AsyncLogger log(make_unique<RotatingFileSink>("rotated.log", RotationOptions{.max_file_size = 8 * 1024, .max_rotated_files = 3, .compress_rotated_files = true}));
 
-    Logger log("data.log");
+        thread thd1(&run<AsyncLogger>, ref(log), 1);
+        thread thd2(&run<AsyncLogger>, ref(log), 2);
 
-    thread thd1(&run, ref(log), 1);
-    thread thd2(&run, ref(log), 2);
+        thd1.join();
+        thd2.join();
+    }
 
-    thd1.join();
-    thd2.join();
+    cout << "data.log: " << filesystem::file_size("data.log") << " bytes; "
+         << "data.blog: " << filesystem::file_size("data.blog") << " bytes" << endl;
 }
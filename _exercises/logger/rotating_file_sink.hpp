@@ -0,0 +1,248 @@
+#ifndef ROTATING_FILE_SINK_HPP
+#define ROTATING_FILE_SINK_HPP
+
+#include "log_sinks.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(LOGGER_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+struct RotationOptions
+{
+    uint64_t max_file_size = 64 * 1024 * 1024;     // 0 - no size limit
+    std::chrono::seconds max_file_age{0};           // 0 - no time limit
+    size_t max_rotated_files = 8;                   // older rotated files are deleted
+    bool compress_rotated_files = false;            // gzip - only when built with zlib
+};
+
+// Log file rotated by size and/or age: <file_name> is the active file, rotated files are
+// <file_name>.000001, <file_name>.000002, ... (.gz when compressed) - the highest index is the newest one.
+//
+// The writer thread only closes, renames and reopens the file. Compression and deletion of old files
+// are done by a housekeeping thread, so a slow disk operation never holds up the writer
+// (and the producer threads waiting for space in their buffers).
+// The active file may exceed max_file_size by the size of one batch.
+class RotatingFileSink : public LogSink
+{
+public:
+    explicit RotatingFileSink(std::string file_name, RotationOptions options = {})
+        : file_name_{std::move(file_name)}
+        , options_{options}
+        , next_index_{last_rotated_index() + 1}
+        , housekeeper_{[this](std::stop_token stop_token) { housekeeping_loop(stop_token); }}
+    {
+        open(std::ios::app);
+
+        if (file_size_ > 0) // file left by a previous run
+            roll();
+    }
+
+    RotatingFileSink(const RotatingFileSink&) = delete;
+    RotatingFileSink& operator=(const RotatingFileSink&) = delete;
+
+    ~RotatingFileSink() override
+    {
+        fout_.close();
+        housekeeper_.request_stop(); // pending rotated files are processed before the thread finishes
+    }
+
+    void write(std::string_view data) override
+    {
+        fout_.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file_size_ += data.size();
+    }
+
+    void flush() override
+    {
+        fout_.flush();
+    }
+
+    bool roll_if_due() override
+    {
+        const bool is_too_big = options_.max_file_size > 0 && file_size_ >= options_.max_file_size;
+        const bool is_too_old = options_.max_file_age.count() > 0 && file_size_ > 0 && std::chrono::steady_clock::now() - opened_at_ >= options_.max_file_age;
+
+        if (!is_too_big && !is_too_old)
+            return false;
+
+        return roll();
+    }
+
+private:
+    const std::string file_name_;
+    const RotationOptions options_;
+    std::ofstream fout_;
+    uint64_t file_size_ = 0;
+    std::chrono::steady_clock::time_point opened_at_;
+    uint64_t next_index_;
+
+    std::mutex housekeeping_mtx_;
+    std::condition_variable_any housekeeping_cv_;
+    std::deque<std::string> rotated_files_; // waiting for compression and retention
+
+    std::jthread housekeeper_; // must be the last member
+
+    bool roll()
+    {
+        fout_.close();
+
+        const std::string rotated_path = rotated_file_path(next_index_);
+        std::error_code ec;
+        std::filesystem::rename(file_name_, rotated_path, ec);
+        if (ec)
+        {
+            open(std::ios::app); // keep writing to the current file - rotation is retried before the next batch
+            return false;
+        }
+        ++next_index_;
+
+        {
+            std::lock_guard lk{housekeeping_mtx_};
+            rotated_files_.push_back(rotated_path);
+        }
+        housekeeping_cv_.notify_one();
+
+        open(std::ios::out | std::ios::trunc);
+        return true;
+    }
+
+    void open(std::ios::openmode mode)
+    {
+        fout_.open(file_name_, std::ios::binary | mode);
+        if (!fout_)
+            throw std::runtime_error("Cannot open log file: " + file_name_);
+
+        fout_.seekp(0, std::ios::end);
+        file_size_ = static_cast<uint64_t>(fout_.tellp());
+        opened_at_ = std::chrono::steady_clock::now();
+    }
+
+    std::string rotated_file_path(uint64_t index) const
+    {
+        std::string suffix = std::to_string(index);
+        return file_name_ + "." + std::string(6 - std::min<size_t>(suffix.size(), 6), '0') + suffix;
+    }
+
+    // returns rotated files by index from the oldest one - X.N and X.N.gz (left while X.N is compressed) are one file
+    std::map<uint64_t, std::vector<std::filesystem::path>> rotated_files_on_disk() const
+    {
+        namespace fs = std::filesystem;
+
+        const fs::path active_path{file_name_};
+        const fs::path dir = active_path.has_parent_path() ? active_path.parent_path() : fs::path{"."};
+        const std::string prefix = active_path.filename().string() + ".";
+
+        std::map<uint64_t, std::vector<fs::path>> files;
+
+        for (const auto& entry : fs::directory_iterator{dir})
+        {
+            const std::string file_name = entry.path().filename().string(); // filename() returns a temporary
+            std::string_view name = file_name;
+            if (!name.starts_with(prefix))
+                continue;
+
+            name.remove_prefix(prefix.size());
+            if (name.ends_with(".gz"))
+                name.remove_suffix(3);
+
+            uint64_t index;
+            const auto [end, error] = std::from_chars(name.data(), name.data() + name.size(), index);
+            if (error == std::errc{} && end == name.data() + name.size())
+                files[index].push_back(entry.path());
+        }
+
+        return files;
+    }
+
+    uint64_t last_rotated_index() const
+    {
+        const auto files = rotated_files_on_disk();
+        return files.empty() ? 0 : files.rbegin()->first;
+    }
+
+    void housekeeping_loop(std::stop_token stop_token)
+    {
+        while (true)
+        {
+            std::string rotated_path;
+            {
+                std::unique_lock lk{housekeeping_mtx_};
+                if (!housekeeping_cv_.wait(lk, stop_token, [this] { return !rotated_files_.empty(); }) && rotated_files_.empty())
+                    return;
+
+                rotated_path = std::move(rotated_files_.front());
+                rotated_files_.pop_front();
+            }
+
+            if (options_.compress_rotated_files)
+                compress(rotated_path);
+
+            remove_old_files();
+        }
+    }
+
+    static void compress([[maybe_unused]] const std::string& path)
+    {
+#if defined(LOGGER_HAS_ZLIB)
+        std::ifstream fin{path, std::ios::binary};
+        const std::string gz_path = path + ".gz";
+        gzFile gz = gzopen(gz_path.c_str(), "wb");
+        if (!fin || !gz)
+        {
+            if (gz)
+                gzclose(gz);
+            return; // file stays uncompressed
+        }
+
+        std::vector<char> buffer(256 * 1024);
+        bool is_ok = true;
+        while (is_ok && fin)
+        {
+            fin.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            const auto count = static_cast<int>(fin.gcount());
+            if (count > 0)
+                is_ok = gzwrite(gz, buffer.data(), static_cast<unsigned>(count)) == count;
+        }
+
+        is_ok = gzclose(gz) == Z_OK && is_ok;
+        fin.close();
+
+        std::error_code ec;
+        std::filesystem::remove(is_ok ? std::filesystem::path{path} : std::filesystem::path{gz_path}, ec);
+#endif
+    }
+
+    void remove_old_files() const
+    {
+        const auto files = rotated_files_on_disk();
+        if (files.size() <= options_.max_rotated_files)
+            return;
+
+        std::error_code ec;
+        auto it = files.begin();
+        for (size_t i = 0; i < files.size() - options_.max_rotated_files; ++i, ++it)
+        {
+            for (const auto& path : it->second)
+                std::filesystem::remove(path, ec);
+        }
+    }
+};
+
+#endif // ROTATING_FILE_SINK_HPP
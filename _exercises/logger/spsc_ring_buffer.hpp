@@ -0,0 +1,148 @@
+#ifndef SPSC_RING_BUFFER_HPP
+#define SPSC_RING_BUFFER_HPP
+
+#include "cache_line.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+
+// Lock-free single-producer/single-consumer ring buffer of variable-length records.
+//
+// Layout of a record: [uint32 size][uint32 unused][payload...] padded to 8 bytes.
+// A record never wraps around - when it does not fit before the end of the buffer,
+// the producer writes a padding marker and continues from the beginning.
+class SpscRingBuffer
+{
+public:
+    explicit SpscRingBuffer(size_t capacity)
+        : capacity_{std::bit_ceil(std::max<size_t>(capacity, 64))}
+        , data_{std::make_unique<std::byte[]>(capacity_)}
+    {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    static constexpr size_t max_record_size(size_t capacity)
+    {
+        return std::bit_ceil(std::max<size_t>(capacity, 64)) / 2 - header_size;
+    }
+
+    size_t max_record_size() const
+    {
+        return max_record_size(capacity_);
+    }
+
+    // producer: returns place for a record of given size or nullptr when the buffer is full
+    std::byte* try_reserve(size_t size)
+    {
+        if (size > max_record_size())
+            return nullptr;
+
+        const size_t record_size = aligned(header_size + size);
+        const size_t position = tail_ & (capacity_ - 1);
+        const size_t to_end = capacity_ - position;
+        const size_t required = record_size <= to_end ? record_size : to_end + record_size;
+
+        if (tail_ + required - cached_head_ > capacity_)
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail_ + required - cached_head_ > capacity_)
+                return nullptr;
+        }
+
+        size_t start = tail_;
+        if (record_size > to_end)
+        {
+            write_size(position, padding_marker);
+            start += to_end;
+        }
+
+        const size_t record_position = start & (capacity_ - 1);
+        write_size(record_position, static_cast<uint32_t>(size));
+        pending_tail_ = start + record_size;
+
+        return data_.get() + record_position + header_size;
+    }
+
+    // producer: publishes the record returned by the last try_reserve()
+    void commit()
+    {
+        tail_ = pending_tail_;
+        published_tail_.store(tail_, std::memory_order_release);
+    }
+
+    // consumer: calls f(std::span<const std::byte>) for every published record and frees them
+    template <typename F>
+    size_t consume(F&& f)
+    {
+        const size_t tail = published_tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t count = 0;
+
+        while (head != tail)
+        {
+            const size_t position = head & (capacity_ - 1);
+            const uint32_t size = read_size(position);
+
+            if (size == padding_marker)
+            {
+                head += capacity_ - position;
+                continue;
+            }
+
+            f(std::span<const std::byte>{data_.get() + position + header_size, size});
+            head += aligned(header_size + size);
+            ++count;
+        }
+
+        head_.store(head, std::memory_order_release);
+        return count;
+    }
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == published_tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t header_size = 8;
+    static constexpr uint32_t padding_marker = 0xFFFF'FFFF;
+
+    const size_t capacity_;
+    std::unique_ptr<std::byte[]> data_;
+
+    // consumer side
+    alignas(cache_line_size) std::atomic<size_t> head_{0};
+
+    // producer side
+    alignas(cache_line_size) std::atomic<size_t> published_tail_{0};
+    size_t tail_ = 0;
+    size_t pending_tail_ = 0;
+    size_t cached_head_ = 0;
+
+    static size_t aligned(size_t size)
+    {
+        return (size + 7) & ~size_t{7};
+    }
+
+    void write_size(size_t position, uint32_t size)
+    {
+        std::memcpy(data_.get() + position, &size, sizeof(size));
+    }
+
+    uint32_t read_size(size_t position) const
+    {
+        uint32_t size;
+        std::memcpy(&size, data_.get() + position, sizeof(size));
+        return size;
+    }
+};
+
+#endif // SPSC_RING_BUFFER_HPP
@@ -0,0 +1,185 @@
+#include "async_logger.hpp"
+#include "binary_log.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // raw arguments as copied into a producer buffer by AsyncLogger::log<Fmt>()
+    template <typename... TArgs>
+    vector<std::byte> encode_raw_args(const TArgs&... args)
+    {
+        vector<std::byte> raw((size_t{0} + ... + BinaryLog::raw_size(args)));
+        std::byte* dest = raw.data();
+        ((dest = BinaryLog::encode_raw(dest, args)), ...);
+        return raw;
+    }
+
+    template <BinaryLog::FormatString Fmt, typename... TArgs>
+    void append_record(string& out, vector<bool>& defined, int64_t timestamp_delta, const TArgs&... args)
+    {
+        const uint32_t id = BinaryLog::format_id<Fmt, TArgs...>();
+        const BinaryLog::Format& format = BinaryLog::FormatRegistry::instance().get(id);
+
+        if (defined.size() <= id)
+            defined.resize(id + 1);
+        if (!defined[id])
+        {
+            BinaryLog::append_format_definition(out, id, format);
+            defined[id] = true;
+        }
+
+        BinaryLog::append_record(out, id, timestamp_delta, format, encode_raw_args(args...));
+    }
+
+    vector<string> decode_lines(string_view data)
+    {
+        BinaryLog::Decoder decoder{data};
+        vector<string> lines;
+
+        for (string line; decoder.next(line); line.clear())
+            lines.push_back(line);
+
+        return lines;
+    }
+
+    struct StringSink : LogSink
+    {
+        shared_ptr<string> output = make_shared<string>();
+
+        void write(string_view data) override
+        {
+            output->append(data);
+        }
+
+        void flush() override
+        {
+        }
+    };
+}
+
+TEST_CASE("BinaryLog - varint and zigzag encoding")
+{
+    SECTION("varint takes 7 bits per byte")
+    {
+        auto encoded_size = [](uint64_t value) {
+            string out;
+            BinaryLog::append_varint(out, value);
+            return out.size();
+        };
+
+        REQUIRE(encoded_size(0) == 1);
+        REQUIRE(encoded_size(127) == 1);
+        REQUIRE(encoded_size(128) == 2);
+        REQUIRE(encoded_size(numeric_limits<uint64_t>::max()) == 10);
+    }
+
+    SECTION("zigzag maps small negative numbers to small codes")
+    {
+        REQUIRE(BinaryLog::zigzag(0) == 0);
+        REQUIRE(BinaryLog::zigzag(-1) == 1);
+        REQUIRE(BinaryLog::zigzag(1) == 2);
+        REQUIRE(BinaryLog::zigzag(numeric_limits<int64_t>::min()) == numeric_limits<uint64_t>::max());
+
+        for (int64_t value : {int64_t{0}, int64_t{-1}, int64_t{1}, int64_t{-64}, int64_t{64},
+                 numeric_limits<int64_t>::min(), numeric_limits<int64_t>::max()})
+            REQUIRE(BinaryLog::unzigzag(BinaryLog::zigzag(value)) == value);
+    }
+}
+
+TEST_CASE("BinaryLog - records decoded by Decoder")
+{
+    string data;
+    BinaryLog::append_file_header(data);
+    vector<bool> defined;
+
+    SECTION("negative, large and string arguments keep their values")
+    {
+        append_record<"ints {} {} {}">(data, defined, 1'000, -1, numeric_limits<int64_t>::min(), numeric_limits<int64_t>::max());
+        append_record<"uint {}">(data, defined, 10, numeric_limits<uint64_t>::max());
+        append_record<"text '{}' '{}' {}">(data, defined, 10, string_view{"abc"}, string(300, 'x'), 'c');
+        append_record<"mixed {} {} {}">(data, defined, 10, -2.5, true, string{});
+
+        const vector<string> lines = decode_lines(data);
+
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[0] == "ints -1 -9223372036854775808 9223372036854775807\n");
+        REQUIRE(lines[1] == "uint 18446744073709551615\n");
+        REQUIRE(lines[2] == "text 'abc' '" + string(300, 'x') + "' c\n");
+        REQUIRE(lines[3] == "mixed -2.5 true \n");
+    }
+
+    SECTION("format is defined once and reused by later records")
+    {
+        append_record<"value {}">(data, defined, 5, 1);
+        const size_t size_after_first = data.size();
+        append_record<"value {}">(data, defined, 5, 2);
+
+        REQUIRE(data.size() - size_after_first == 3); // id, timestamp delta and a one-byte argument
+
+        append_record<"other {}">(data, defined, 5, 3u);
+        append_record<"value {}">(data, defined, 5, 4);
+
+        REQUIRE(decode_lines(data) == vector<string>{"value 1\n", "value 2\n", "other 3\n", "value 4\n"});
+    }
+
+    SECTION("timestamps are restored from deltas - also negative ones")
+    {
+        append_record<"a">(data, defined, 1'000'000);
+        append_record<"b">(data, defined, -300);
+
+        BinaryLog::Decoder decoder{data};
+        string line;
+
+        REQUIRE(decoder.next(line));
+        REQUIRE(decoder.timestamp_ns() == 1'000'000);
+        REQUIRE(decoder.next(line));
+        REQUIRE(decoder.timestamp_ns() == 999'700);
+        REQUIRE(decoder.next(line) == false);
+    }
+
+    SECTION("record with an undefined format id is rejected")
+    {
+        BinaryLog::append_varint(data, 1'000);
+        BinaryLog::append_varint(data, 0);
+
+        REQUIRE_THROWS_AS(decode_lines(data), runtime_error);
+    }
+
+    SECTION("data without the file header is rejected")
+    {
+        REQUIRE_THROWS_AS(BinaryLog::Decoder{"not a log"}, runtime_error);
+    }
+}
+
+TEST_CASE("AsyncLogger - binary output decodes to the same text")
+{
+    auto sink = make_unique<StringSink>();
+    shared_ptr<string> output = sink->output;
+
+    {
+        AsyncLogger logger{std::move(sink), {.output = LogOutput::binary}};
+
+        logger.log<"negative {} {}">(-42, numeric_limits<int64_t>::min());
+        logger.log<"large {}">(numeric_limits<uint64_t>::max());
+        logger.log<"string {} {}">(string_view{"hello"}, string(1'000, 'y'));
+        logger.log("plain text");
+    }
+
+    REQUIRE(decode_lines(*output)
+        == vector<string>{
+            "negative -42 -9223372036854775808\n",
+            "large 18446744073709551615\n",
+            "string hello " + string(1'000, 'y') + "\n",
+            "plain text\n"});
+}
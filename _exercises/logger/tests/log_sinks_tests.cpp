@@ -0,0 +1,127 @@
+#include "log_sinks.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+#if defined(__unix__)
+namespace
+{
+    struct SegmentFile
+    {
+        LogSegmentHeader header;
+        string data; // bytes after the header - committed or not
+        uintmax_t file_size;
+    };
+
+    SegmentFile read_segment(const string& path)
+    {
+        ifstream fin{path, ios::binary};
+        REQUIRE(fin);
+
+        string content{istreambuf_iterator<char>{fin}, istreambuf_iterator<char>{}};
+        REQUIRE(content.size() >= sizeof(LogSegmentHeader));
+
+        SegmentFile segment;
+        memcpy(&segment.header, content.data(), sizeof(LogSegmentHeader));
+        segment.data = content.substr(sizeof(LogSegmentHeader));
+        segment.file_size = content.size();
+        return segment;
+    }
+
+    // data of a segment as read by log-decoder
+    string_view committed_data(const SegmentFile& segment)
+    {
+        REQUIRE(segment.header.committed_length <= segment.data.size());
+        return string_view{segment.data}.substr(0, segment.header.committed_length);
+    }
+
+    string batch(char fill, size_t size)
+    {
+        return string(size, fill);
+    }
+}
+
+TEST_CASE("MmapSegmentSink")
+{
+    namespace fs = std::filesystem;
+
+    const fs::path dir = fs::temp_directory_path() / ("mmap_segment_sink_tests_" + to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const string base_path = (dir / "app.log").string();
+    constexpr size_t segment_size = sizeof(LogSegmentHeader) + 4096;
+
+    SECTION("moves a batch that does not fit to the next segment")
+    {
+        {
+            MmapSegmentSink sink{base_path, segment_size};
+            for (char fill = 'a'; fill < 'a' + 10; ++fill)
+                sink.write(batch(fill, 1'000));
+        }
+
+        REQUIRE(MmapSegmentSink::segment_path(base_path, 0) == base_path + ".000000");
+        REQUIRE(fs::exists(MmapSegmentSink::segment_path(base_path, 3)) == false);
+
+        string all_data;
+        for (uint64_t index = 0; index < 3; ++index)
+        {
+            const SegmentFile segment = read_segment(MmapSegmentSink::segment_path(base_path, index));
+
+            REQUIRE(memcmp(segment.header.magic, LogSegmentHeader::magic_value, sizeof(segment.header.magic)) == 0);
+            REQUIRE(segment.header.version == 1);
+            REQUIRE(segment.header.index == index);
+            REQUIRE(segment.header.committed_length == (index < 2 ? 4'000 : 2'000)); // 4 batches fit into 4096 bytes
+            REQUIRE(segment.file_size == sizeof(LogSegmentHeader) + segment.header.committed_length); // preallocated space is released
+
+            all_data += committed_data(segment);
+        }
+
+        string expected;
+        for (char fill = 'a'; fill < 'a' + 10; ++fill)
+            expected += batch(fill, 1'000);
+        REQUIRE(all_data == expected);
+    }
+
+    SECTION("splits a batch larger than a whole segment")
+    {
+        {
+            MmapSegmentSink sink{base_path, segment_size};
+            sink.write(batch('x', 10'000));
+        }
+
+        const SegmentFile first = read_segment(MmapSegmentSink::segment_path(base_path, 0));
+        const SegmentFile second = read_segment(MmapSegmentSink::segment_path(base_path, 1));
+        const SegmentFile third = read_segment(MmapSegmentSink::segment_path(base_path, 2));
+
+        REQUIRE(first.header.committed_length == 4'096);
+        REQUIRE(second.header.committed_length == 4'096);
+        REQUIRE(third.header.committed_length == 10'000 - 2 * 4'096);
+        REQUIRE(string{committed_data(first)} + string{committed_data(second)} + string{committed_data(third)} == batch('x', 10'000));
+    }
+
+    SECTION("committed length bounds the data of a segment that is still open")
+    {
+        MmapSegmentSink sink{base_path, segment_size};
+        sink.write("first batch\n");
+        sink.write("second batch\n");
+
+        // as after a crash of the process - the file keeps its preallocated size
+        const SegmentFile segment = read_segment(MmapSegmentSink::segment_path(base_path, 0));
+
+        REQUIRE(segment.file_size == segment_size);
+        REQUIRE(segment.header.committed_length == 25);
+        REQUIRE(committed_data(segment) == "first batch\nsecond batch\n");
+        REQUIRE(segment.data.find_first_not_of('\0', segment.header.committed_length) == string::npos);
+    }
+
+    fs::remove_all(dir);
+}
+#endif
@@ -0,0 +1,369 @@
+#include "async_logger.hpp"
+#include "log_filters.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // keeps everything written by the logger - shared with the test, which outlives the logger
+    struct StringSink : LogSink
+    {
+        shared_ptr<string> output = make_shared<string>();
+
+        void write(string_view data) override
+        {
+            output->append(data);
+        }
+
+        void flush() override
+        {
+        }
+    };
+
+    // keeps written data and the part of it handed over by the last flush()
+    struct FlushedData
+    {
+        mutable mutex mtx;
+        string written;
+        string flushed;
+
+        string get_flushed() const
+        {
+            lock_guard lk{mtx};
+            return flushed;
+        }
+
+        string get_written() const
+        {
+            lock_guard lk{mtx};
+            return written;
+        }
+    };
+
+    struct FlushRecordingSink : LogSink
+    {
+        shared_ptr<FlushedData> data = make_shared<FlushedData>();
+
+        void write(string_view text) override
+        {
+            lock_guard lk{data->mtx};
+            data->written.append(text);
+        }
+
+        void flush() override
+        {
+            lock_guard lk{data->mtx};
+            data->flushed = data->written;
+        }
+    };
+
+    unique_ptr<FlushRecordingSink> make_sink(shared_ptr<FlushedData>& data)
+    {
+        auto sink = make_unique<FlushRecordingSink>();
+        data = sink->data;
+        return sink;
+    }
+
+    template <typename TPredicate>
+    bool wait_until(TPredicate predicate, chrono::milliseconds timeout = 5s)
+    {
+        const auto deadline = chrono::steady_clock::now() + timeout;
+        while (!predicate())
+        {
+            if (chrono::steady_clock::now() > deadline)
+                return false;
+            this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+
+    unique_ptr<StringSink> make_sink(shared_ptr<string>& output)
+    {
+        auto sink = make_unique<StringSink>();
+        output = sink->output;
+        return sink;
+    }
+
+    size_t occurrences(const string& output, string_view text)
+    {
+        size_t count = 0;
+        for (size_t pos = output.find(text); pos != string::npos; pos = output.find(text, pos + text.size()))
+            ++count;
+        return count;
+    }
+
+    // sum of counts in reports "[logger] N <what>" - the writer thread may report a count in parts
+    uint64_t reported_count(const string& output, string_view what)
+    {
+        const string prefix = "[logger] ";
+        uint64_t sum = 0;
+
+        for (size_t pos = output.find(prefix); pos != string::npos; pos = output.find(prefix, pos + 1))
+        {
+            const size_t count_end = output.find(' ', pos + prefix.size());
+            if (output.compare(count_end + 1, what.size(), what) == 0)
+                sum += stoull(output.substr(pos + prefix.size(), count_end - pos - prefix.size()));
+        }
+
+        return sum;
+    }
+}
+
+TEST_CASE("AsyncLogger - suppressed messages")
+{
+    shared_ptr<string> output;
+
+    SECTION("are counted when the thread exits right after them")
+    {
+        uint64_t suppressed = 0;
+
+        {
+            AsyncLogger logger{make_sink(output)};
+
+            thread thd{[&logger] {
+                for (int i = 0; i < 500; ++i)
+                    LOG_RATE_LIMITED(logger, Severity::info, 1.0, "event {}", i);
+            }};
+            thd.join();
+
+            logger.flush();
+
+            // a slow runner may let a second message pass after a second - every call is either emitted or suppressed
+            suppressed = logger.suppressed_count();
+            REQUIRE(suppressed >= 498);
+        }
+
+        REQUIRE(output->find("event 0\n") != string::npos);
+        REQUIRE(occurrences(*output, "event ") + suppressed == 500);
+        REQUIRE(reported_count(*output, "messages suppressed") == suppressed);
+    }
+
+    SECTION("rate limiter rejects a rate that is not positive")
+    {
+        REQUIRE_THROWS_AS(LogRateLimiter{0.0}, invalid_argument);
+        REQUIRE_THROWS_AS(LogRateLimiter{-1.0}, invalid_argument);
+    }
+
+    SECTION("are counted for every thread by sampling")
+    {
+        AsyncLogger logger{make_sink(output)};
+
+        auto sample = [&logger] {
+            for (int i = 0; i < 100; ++i)
+                LOG_EVERY_N(logger, Severity::info, 10, "sample {}", i);
+        };
+
+        thread thd1{sample};
+        thread thd2{sample};
+        thd1.join();
+        thd2.join();
+
+        logger.flush();
+
+        REQUIRE(logger.suppressed_count() == 180);
+    }
+}
+
+TEST_CASE("AsyncLogger - dropped messages")
+{
+    shared_ptr<string> output;
+
+    SECTION("are reported when the logger is destroyed")
+    {
+        {
+            AsyncLogger logger{make_sink(output), {.buffer_capacity = 64, .overflow_policy = OverflowPolicy::drop}};
+
+            logger.log<"{}">(string(10'000, 'x'));
+
+            REQUIRE(logger.dropped_count() == 1);
+        }
+
+        REQUIRE(reported_count(*output, "messages dropped") == 1);
+    }
+}
+
+TEST_CASE("AsyncLogger - overflow policy")
+{
+    shared_ptr<string> output;
+    constexpr int count = 10'000;
+
+    SECTION("block - producer waits for space and no message is lost")
+    {
+        AsyncLogger logger{make_sink(output), {.buffer_capacity = 64, .overflow_policy = OverflowPolicy::block}};
+
+        for (int i = 0; i < count; ++i)
+            logger.log<"message {}">(i);
+
+        logger.flush();
+
+        REQUIRE(logger.dropped_count() == 0);
+        REQUIRE(occurrences(*output, "message ") == count);
+        REQUIRE(output->find("message 9999\n") != string::npos);
+    }
+
+    SECTION("drop - every message is either written or counted as dropped")
+    {
+        uint64_t dropped = 0;
+
+        {
+            AsyncLogger logger{make_sink(output), {.buffer_capacity = 64, .overflow_policy = OverflowPolicy::drop}};
+
+            for (int i = 0; i < count; ++i)
+                logger.log<"message {}">(i);
+
+            logger.flush();
+
+            dropped = logger.dropped_count();
+            REQUIRE(occurrences(*output, "message ") + dropped == count);
+        }
+
+        REQUIRE(reported_count(*output, "messages dropped") == dropped);
+    }
+}
+
+TEST_CASE("AsyncLogger - buffers of finished threads")
+{
+    shared_ptr<string> output;
+
+    SECTION("records logged right before a thread exits are written")
+    {
+        AsyncLogger logger{make_sink(output)};
+
+        vector<thread> threads;
+        for (int i = 0; i < 50; ++i)
+            threads.emplace_back([&logger, i] { logger.log<"thread {} exits">(i); });
+
+        for (auto& thd : threads)
+            thd.join();
+
+        logger.flush();
+
+        REQUIRE(occurrences(*output, " exits\n") == 50);
+        for (int i = 0; i < 50; ++i)
+            REQUIRE(output->find("thread " + to_string(i) + " exits\n") != string::npos);
+    }
+
+    SECTION("counters of a thread are kept after its buffer is removed")
+    {
+        AsyncLogger logger{make_sink(output), {.buffer_capacity = 64, .overflow_policy = OverflowPolicy::drop}};
+
+        thread thd{[&logger] {
+            logger.log<"{}">(string(10'000, 'x'));
+            for (int i = 0; i < 2; ++i)
+                LOG_EVERY_N(logger, Severity::info, 2, "sample {}", i);
+        }};
+        thd.join();
+
+        logger.flush(); // the drain after the request sees the thread finished and removes its buffer
+        logger.flush();
+
+        REQUIRE(logger.dropped_count() == 1);
+        REQUIRE(logger.suppressed_count() == 1);
+        REQUIRE(output->find("sample 0\n") != string::npos);
+    }
+
+    SECTION("a new thread gets its own buffer after other threads have finished")
+    {
+        AsyncLogger logger{make_sink(output)};
+
+        for (int i = 0; i < 3; ++i)
+        {
+            thread thd{[&logger, i] { logger.log<"round {}">(i); }};
+            thd.join();
+            logger.flush();
+
+            REQUIRE(output->find("round " + to_string(i) + "\n") != string::npos);
+        }
+    }
+}
+
+TEST_CASE("AsyncLogger - flush")
+{
+    shared_ptr<FlushedData> data;
+
+    SECTION("flush() returns after all records logged before it are flushed")
+    {
+        AsyncLogger logger{make_sink(data), {.flush_policy = {.every_records = 0, .every_interval = 0ms, .on_severity = Severity::off}}};
+
+        for (int i = 0; i < 100; ++i)
+            logger.log<"message {}">(i);
+
+        logger.flush();
+
+        REQUIRE(logger.flush_count() == 1);
+        REQUIRE(occurrences(data->get_flushed(), "message ") == 100);
+    }
+
+    SECTION("flush() without new records does not flush the sink")
+    {
+        AsyncLogger logger{make_sink(data)};
+
+        logger.flush();
+        logger.log("message");
+        logger.flush();
+        const uint64_t flush_count = logger.flush_count();
+        logger.flush();
+
+        REQUIRE(flush_count >= 1);
+        REQUIRE(logger.flush_count() == flush_count);
+    }
+
+    SECTION("every N records")
+    {
+        AsyncLogger logger{make_sink(data), {.flush_policy = {.every_records = 10, .every_interval = 0ms, .on_severity = Severity::off}}};
+
+        for (int i = 0; i < 9; ++i)
+            logger.log<"message {}">(i);
+
+        REQUIRE(wait_until([&] { return occurrences(data->get_written(), "message ") == 9; }));
+        this_thread::sleep_for(20ms);
+        REQUIRE(logger.flush_count() == 0);
+
+        logger.log<"message {}">(9);
+
+        REQUIRE(wait_until([&] { return logger.flush_count() == 1; }));
+        REQUIRE(occurrences(data->get_flushed(), "message ") == 10);
+    }
+
+    SECTION("every T milliseconds")
+    {
+        const auto start = chrono::steady_clock::now();
+        AsyncLogger logger{make_sink(data), {.flush_policy = {.every_records = 0, .every_interval = 50ms, .on_severity = Severity::off}}};
+
+        logger.log("message");
+
+        REQUIRE(wait_until([&] { return logger.flush_count() == 1; }));
+        REQUIRE(chrono::steady_clock::now() - start >= 50ms);
+        REQUIRE(data->get_flushed() == "message\n");
+
+        this_thread::sleep_for(120ms); // nothing new to flush
+        REQUIRE(logger.flush_count() == 1);
+    }
+
+    SECTION("record of severity error or higher")
+    {
+        AsyncLogger logger{make_sink(data), {.flush_policy = {.every_records = 0, .every_interval = 0ms, .on_severity = Severity::error}}};
+
+        logger.log<"message {}">(Severity::warning, 1);
+
+        REQUIRE(wait_until([&] { return !data->get_written().empty(); }));
+        this_thread::sleep_for(20ms);
+        REQUIRE(logger.flush_count() == 0);
+
+        logger.log<"message {}">(Severity::error, 2);
+
+        REQUIRE(wait_until([&] { return logger.flush_count() == 1; }));
+        REQUIRE(data->get_flushed() == "message 1\nmessage 2\n");
+    }
+}
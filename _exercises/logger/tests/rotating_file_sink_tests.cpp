@@ -0,0 +1,113 @@
+#include "rotating_file_sink.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    set<string> file_names(const fs::path& dir)
+    {
+        set<string> names;
+        for (const auto& entry : fs::directory_iterator{dir})
+            names.insert(entry.path().filename().string());
+        return names;
+    }
+
+    string read_file(const fs::path& path)
+    {
+        ifstream fin{path, ios::binary};
+        return string{istreambuf_iterator<char>{fin}, istreambuf_iterator<char>{}};
+    }
+
+    void create_file(const fs::path& path, const string& content)
+    {
+        ofstream{path, ios::binary} << content;
+    }
+
+    // one batch of the writer thread
+    void write_batch(RotatingFileSink& sink, const string& data)
+    {
+        sink.roll_if_due();
+        sink.write(data);
+        sink.flush();
+    }
+}
+
+TEST_CASE("RotatingFileSink")
+{
+    const fs::path dir = fs::temp_directory_path() / ("rotating_file_sink_tests_" + to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const string file_name = (dir / "app.log").string();
+
+    SECTION("rotates the file when it reaches max_file_size")
+    {
+        {
+            RotatingFileSink sink{file_name, {.max_file_size = 10, .max_file_age = 0s, .max_rotated_files = 8, .compress_rotated_files = false}};
+
+            write_batch(sink, "first-batch\n");
+            write_batch(sink, "second-batch\n");
+            write_batch(sink, "third\n");
+        }
+
+        REQUIRE(file_names(dir) == set<string>{"app.log", "app.log.000001", "app.log.000002"});
+        REQUIRE(read_file(dir / "app.log.000001") == "first-batch\n");
+        REQUIRE(read_file(dir / "app.log.000002") == "second-batch\n");
+        REQUIRE(read_file(dir / "app.log") == "third\n");
+    }
+
+    SECTION("keeps only max_rotated_files newest rotated files")
+    {
+        {
+            RotatingFileSink sink{file_name, {.max_file_size = 1, .max_file_age = 0s, .max_rotated_files = 2, .compress_rotated_files = false}};
+
+            for (int i = 1; i <= 5; ++i)
+                write_batch(sink, "batch " + to_string(i) + "\n");
+        }
+
+        REQUIRE(file_names(dir) == set<string>{"app.log", "app.log.000003", "app.log.000004"});
+        REQUIRE(read_file(dir / "app.log.000004") == "batch 4\n");
+    }
+
+    SECTION("counts a file and its compressed copy as one rotated file")
+    {
+        create_file(dir / "app.log.000001", "old 1\n");
+        create_file(dir / "app.log.000002", "old 2\n");
+        create_file(dir / "app.log.000002.gz", "partial"); // compression interrupted by the end of the previous run
+
+        {
+            RotatingFileSink sink{file_name, {.max_file_size = 1, .max_file_age = 0s, .max_rotated_files = 3, .compress_rotated_files = false}};
+
+            write_batch(sink, "new 3\n");
+            write_batch(sink, "new 4\n");
+        }
+
+        REQUIRE(file_names(dir) == set<string>{"app.log", "app.log.000001", "app.log.000002", "app.log.000002.gz", "app.log.000003"});
+        REQUIRE(read_file(dir / "app.log.000003") == "new 3\n");
+    }
+
+    SECTION("continues numbering after rotated files of a previous run")
+    {
+        create_file(dir / "app.log.000007.gz", "old\n");
+        create_file(file_name, "left by the previous run\n");
+
+        {
+            RotatingFileSink sink{file_name, {.max_file_size = 0, .max_file_age = 0s, .max_rotated_files = 8, .compress_rotated_files = false}};
+            write_batch(sink, "new\n");
+        }
+
+        REQUIRE(file_names(dir) == set<string>{"app.log", "app.log.000007.gz", "app.log.000008"});
+        REQUIRE(read_file(dir / "app.log.000008") == "left by the previous run\n");
+        REQUIRE(read_file(file_name) == "new\n");
+    }
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,135 @@
+#include "spsc_ring_buffer.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    bool try_push(SpscRingBuffer& ring, uint64_t value, size_t size = sizeof(uint64_t))
+    {
+        std::byte* record = ring.try_reserve(size);
+        if (!record)
+            return false;
+
+        memset(record, 0, size);
+        memcpy(record, &value, sizeof(value));
+        ring.commit();
+        return true;
+    }
+
+    vector<uint64_t> pop_all(SpscRingBuffer& ring)
+    {
+        vector<uint64_t> values;
+        ring.consume([&values](span<const std::byte> record) {
+            uint64_t value;
+            memcpy(&value, record.data(), sizeof(value));
+            values.push_back(value);
+        });
+        return values;
+    }
+}
+
+TEST_CASE("SpscRingBuffer")
+{
+    SpscRingBuffer ring{64}; // records of 12 bytes take 24 bytes with the header
+
+    SECTION("is empty after creation")
+    {
+        REQUIRE(ring.empty());
+        REQUIRE(ring.max_record_size() == 24);
+    }
+
+    SECTION("rejects a record larger than half of the capacity")
+    {
+        REQUIRE(ring.try_reserve(25) == nullptr);
+    }
+
+    SECTION("rejects a record when the buffer is full")
+    {
+        REQUIRE(try_push(ring, 1, 12));
+        REQUIRE(try_push(ring, 2, 12));
+        REQUIRE(try_push(ring, 3, 12) == false); // 16 bytes left before the end
+
+        REQUIRE(pop_all(ring) == vector<uint64_t>{1, 2});
+        REQUIRE(ring.empty());
+    }
+
+    SECTION("skips a padding record when a record does not fit before the end")
+    {
+        REQUIRE(try_push(ring, 1, 12));
+        REQUIRE(try_push(ring, 2, 12));
+        REQUIRE(pop_all(ring).size() == 2);
+
+        REQUIRE(try_push(ring, 3, 12)); // padding at offset 48, record at offset 0
+        REQUIRE(try_push(ring, 4, 12));
+
+        REQUIRE(pop_all(ring) == vector<uint64_t>{3, 4});
+        REQUIRE(ring.empty());
+    }
+
+    SECTION("counts the padding as used space")
+    {
+        REQUIRE(try_push(ring, 1, 12));
+        REQUIRE(try_push(ring, 2, 12));
+        REQUIRE(ring.consume([](span<const std::byte>) {}) == 2);
+
+        REQUIRE(try_push(ring, 3, 12));
+        REQUIRE(try_push(ring, 4, 12));
+        REQUIRE(try_push(ring, 5, 12) == false); // 16 bytes of padding + 48 bytes of records
+    }
+
+    SECTION("keeps records of different sizes in order over many wrap-arounds")
+    {
+        uint64_t next_pushed = 0;
+        uint64_t next_popped = 0;
+
+        for (int round = 0; round < 1'000; ++round)
+        {
+            while (try_push(ring, next_pushed, 8 + next_pushed % 17))
+                ++next_pushed;
+
+            for (uint64_t value : pop_all(ring))
+                REQUIRE(value == next_popped++);
+        }
+
+        REQUIRE(next_popped == next_pushed);
+        REQUIRE(next_pushed >= 1'000); // at least one record fits into an empty buffer
+    }
+
+    SECTION("passes records from a producer thread to a consumer thread")
+    {
+        constexpr uint64_t count = 100'000;
+
+        thread producer{[&ring] {
+            for (uint64_t value = 0; value < count; ++value)
+                while (!try_push(ring, value, 8 + value % 17))
+                    this_thread::yield();
+        }};
+
+        uint64_t next_popped = 0;
+        bool is_ordered = true;
+        while (next_popped < count)
+        {
+            const size_t popped = ring.consume([&](span<const std::byte> record) {
+                uint64_t value;
+                memcpy(&value, record.data(), sizeof(value));
+                is_ordered &= value == next_popped++;
+            });
+
+            if (popped == 0)
+                this_thread::yield();
+        }
+
+        producer.join();
+
+        REQUIRE(is_ordered);
+        REQUIRE(ring.empty());
+    }
+}
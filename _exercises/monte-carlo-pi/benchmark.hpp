@@ -0,0 +1,212 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <numeric>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct Statistics
+{
+    double mean_ms;
+    double median_ms;
+    double stddev_ms;
+    double min_ms;
+};
+
+inline Statistics compute_statistics(std::vector<double> samples_ms)
+{
+    if (samples_ms.empty())
+        return {};
+
+    std::sort(samples_ms.begin(), samples_ms.end());
+
+    const double n = static_cast<double>(samples_ms.size());
+    const double mean = std::accumulate(samples_ms.begin(), samples_ms.end(), 0.0) / n;
+    const size_t middle = samples_ms.size() / 2;
+    const double median = samples_ms.size() % 2 ? samples_ms[middle] : (samples_ms[middle - 1] + samples_ms[middle]) / 2;
+
+    double squares = 0.0;
+    for (double sample : samples_ms)
+        squares += (sample - mean) * (sample - mean);
+    const double stddev = samples_ms.size() > 1 ? std::sqrt(squares / (n - 1)) : 0.0; // sample standard deviation
+
+    return {mean, median, stddev, samples_ms.front()};
+}
+
+struct Scaling
+{
+    double speedup;    // T1 / Tp
+    double efficiency; // speedup / p
+    std::optional<double> serial_fraction; // Karp-Flatt metric: (1/speedup - 1/p) / (1 - 1/p), defined for p > 1
+};
+
+inline Scaling compute_scaling(double baseline_ms, double time_ms, uint32_t threads_count)
+{
+    const double p = threads_count;
+    const double speedup = time_ms > 0 ? baseline_ms / time_ms : 0.0;
+
+    std::optional<double> serial_fraction;
+    if (threads_count > 1 && speedup > 0)
+        serial_fraction = (1.0 / speedup - 1.0 / p) / (1.0 - 1.0 / p);
+
+    return {speedup, speedup / p, serial_fraction};
+}
+
+struct BenchmarkResult
+{
+    std::string name;
+    uint32_t threads_count;
+    uintmax_t points; // drawn by the strategy - may be more than the requested N
+    double pi;
+    Statistics time;
+    PerfReading counters; // of one additional run - empty without --perf
+    std::optional<Scaling> scaling; // relative to the same strategy with 1 thread - only in the scaling mode
+
+    double points_per_second() const // based on median time
+    {
+        return time.median_ms > 0 ? static_cast<double>(points) / (time.median_ms / 1000.0) : 0.0;
+    }
+};
+
+// runs f() warmup times without measuring, then repetitions times - returns the last result and times of measured runs
+template <typename F>
+auto measure(int warmup, int repetitions, F f)
+{
+    for (int i = 0; i < warmup; ++i)
+        f();
+
+    std::vector<double> samples_ms;
+    decltype(f()) result{};
+
+    for (int i = 0; i < repetitions; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        result = f();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        samples_ms.push_back(elapsed.count());
+    }
+
+    return std::pair{result, compute_statistics(std::move(samples_ms))};
+}
+
+inline void print_table_header(std::ostream& out)
+{
+    out << std::left << std::setw(30) << "strategy" << std::right << std::setw(8) << "threads" << std::setw(14) << "pi"
+        << std::setw(11) << "mean ms" << std::setw(11) << "median ms" << std::setw(11) << "stddev ms" << std::setw(11) << "min ms"
+        << std::setw(14) << "points" << std::setw(16) << "points/s" << '\n';
+}
+
+inline void print_table_row(std::ostream& out, const BenchmarkResult& r)
+{
+    out << std::left << std::setw(30) << r.name << std::right << std::setw(8) << r.threads_count
+        << std::setw(14) << std::fixed << std::setprecision(9) << r.pi << std::setprecision(2)
+        << std::setw(11) << r.time.mean_ms << std::setw(11) << r.time.median_ms << std::setw(11) << r.time.stddev_ms << std::setw(11) << r.time.min_ms
+        << std::setw(14) << r.points << std::setw(16) << std::scientific << std::setprecision(3) << r.points_per_second() << std::defaultfloat << '\n';
+}
+
+inline void print_scaling_header(std::ostream& out)
+{
+    out << std::left << std::setw(30) << "strategy" << std::right << std::setw(8) << "threads" << std::setw(11) << "median ms"
+        << std::setw(16) << "points/s" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::setw(17) << "serial fraction" << '\n';
+}
+
+inline void print_scaling_row(std::ostream& out, const BenchmarkResult& r)
+{
+    out << std::left << std::setw(30) << r.name << std::right << std::setw(8) << r.threads_count
+        << std::setw(11) << std::fixed << std::setprecision(2) << r.time.median_ms
+        << std::setw(16) << std::scientific << std::setprecision(3) << r.points_per_second() << std::fixed;
+
+    if (r.scaling)
+    {
+        out << std::setw(10) << std::setprecision(2) << r.scaling->speedup << std::setw(12) << std::setprecision(3) << r.scaling->efficiency;
+        if (r.scaling->serial_fraction)
+            out << std::setw(17) << std::setprecision(4) << *r.scaling->serial_fraction;
+        else
+            out << std::setw(17) << "-";
+    }
+    out << std::defaultfloat << '\n';
+}
+
+inline void print_counters_header(std::ostream& out)
+{
+    out << std::left << std::setw(30) << "strategy" << std::right << std::setw(8) << "threads";
+    for (std::string_view name : perf_event_names)
+        out << std::setw(14) << name;
+    out << std::setw(8) << "IPC" << '\n';
+}
+
+inline void print_counters_row(std::ostream& out, const BenchmarkResult& r)
+{
+    out << std::left << std::setw(30) << r.name << std::right << std::setw(8) << r.threads_count << std::scientific << std::setprecision(3);
+    for (const auto& value : r.counters.values)
+    {
+        if (value)
+            out << std::setw(14) << *value;
+        else
+            out << std::setw(14) << "n/a";
+    }
+
+    if (const auto ipc = r.counters.ipc())
+        out << std::setw(8) << std::fixed << std::setprecision(2) << *ipc;
+    else
+        out << std::setw(8) << "n/a";
+    out << std::defaultfloat << '\n';
+}
+
+inline void print_json(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult& r = results[i];
+        out << std::setprecision(12)
+            << "  {\"strategy\": \"" << r.name << "\", \"threads\": " << r.threads_count << ", \"points\": " << r.points
+            << ", \"pi\": " << r.pi
+            << ", \"mean_ms\": " << r.time.mean_ms << ", \"median_ms\": " << r.time.median_ms
+            << ", \"stddev_ms\": " << r.time.stddev_ms << ", \"min_ms\": " << r.time.min_ms
+            << ", \"points_per_second\": " << r.points_per_second();
+
+        if (r.scaling)
+        {
+            out << ", \"speedup\": " << r.scaling->speedup << ", \"efficiency\": " << r.scaling->efficiency << ", \"serial_fraction\": ";
+            if (r.scaling->serial_fraction)
+                out << *r.scaling->serial_fraction;
+            else
+                out << "null";
+        }
+
+        if (r.counters.has_values())
+        {
+            out << ", \"counters\": {";
+            for (size_t e = 0; e < perf_events_count; ++e)
+            {
+                out << (e > 0 ? ", " : "") << "\"" << perf_event_names[e] << "\": ";
+                if (r.counters.values[e])
+                    out << *r.counters.values[e];
+                else
+                    out << "null";
+            }
+            out << ", \"ipc\": ";
+            if (const auto ipc = r.counters.ipc())
+                out << *ipc;
+            else
+                out << "null";
+            out << "}";
+        }
+
+        out << "}" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "]" << std::endl;
+}
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,304 @@
+#ifndef MONTE_CARLO_HPP
+#define MONTE_CARLO_HPP
+
+#include "cache_line.hpp"
+#include "rng_policies.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace MonteCarlo
+{
+    template <size_t Dims>
+    struct Box
+    {
+        std::array<double, Dims> lower;
+        std::array<double, Dims> upper;
+
+        double volume() const
+        {
+            double volume = 1.0;
+            for (size_t d = 0; d < Dims; ++d)
+                volume *= upper[d] - lower[d];
+            return volume;
+        }
+    };
+
+    template <size_t Dims>
+    using Point = std::array<double, Dims>;
+
+    struct Options
+    {
+        uintmax_t samples = 10'000'000;
+        uint32_t threads_count = std::max(std::thread::hardware_concurrency(), 1u);
+        uint64_t seed = 2024;
+        uint32_t strata_per_dimension = 1; // > 1 - stratified sampling: the box is split into strata_per_dimension^Dims cells
+    };
+
+    struct Result
+    {
+        double estimate;
+        double standard_error;
+        uintmax_t samples; // rounded up to whole streams
+    };
+
+    // sums of one thread - padded like Hits in pi.cpp, so threads never share a cache line
+    struct alignas(cache_line_size) Accumulator
+    {
+        double sum = 0.0;            // of f values
+        double sum_of_squares = 0.0; // of f values
+        double batch_sum = 0.0;      // of stream means
+        double batch_sum_of_squares = 0.0;
+        uintmax_t samples = 0;
+        uintmax_t batches = 0;
+
+        Accumulator& operator+=(const Accumulator& other)
+        {
+            sum += other.sum;
+            sum_of_squares += other.sum_of_squares;
+            batch_sum += other.batch_sum;
+            batch_sum_of_squares += other.batch_sum_of_squares;
+            samples += other.samples;
+            batches += other.batches;
+            return *this;
+        }
+    };
+
+    namespace Details
+    {
+        constexpr uintmax_t min_samples_per_stream = 1 << 16;
+
+        template <size_t Dims>
+        uintmax_t strata_count(uint32_t strata_per_dimension)
+        {
+            uintmax_t count = 1;
+            for (size_t d = 0; d < Dims; ++d)
+                count *= strata_per_dimension;
+            return count;
+        }
+
+        // every stream is a complete stratified design - a whole number of cycles through all strata
+        template <size_t Dims>
+        uintmax_t samples_per_stream(uint32_t strata_per_dimension)
+        {
+            const uintmax_t strata = strata_count<Dims>(strata_per_dimension);
+            return (min_samples_per_stream + strata - 1) / strata * strata;
+        }
+
+        template <typename TRng, size_t Dims, typename TIntegrand>
+        void integrate_streams(TIntegrand& f, const Box<Dims>& box, uint64_t seed, uint32_t strata_per_dimension,
+            uint64_t first_stream, uint64_t last_stream, Accumulator& result)
+        {
+            const uintmax_t stream_size = samples_per_stream<Dims>(strata_per_dimension);
+            const uintmax_t strata = strata_count<Dims>(strata_per_dimension);
+
+            Point<Dims> width;
+            for (size_t d = 0; d < Dims; ++d)
+                width[d] = (box.upper[d] - box.lower[d]) / strata_per_dimension;
+
+            Accumulator local; // in registers during the hot loop
+
+            for (uint64_t stream = first_stream; stream < last_stream; ++stream)
+            {
+                TRng rnd_gen{seed, stream};
+                double stream_sum = 0.0;
+
+                for (uintmax_t n = 0; n < stream_size; ++n)
+                {
+                    Point<Dims> x;
+
+                    if (strata == 1)
+                    {
+                        for (size_t d = 0; d < Dims; ++d)
+                            x[d] = box.lower[d] + rnd_gen.next_double() * width[d];
+                    }
+                    else
+                    {
+                        // samples cycle through strata - coordinates of the cell are digits of n % strata in base strata_per_dimension
+                        uintmax_t cell = n % strata;
+                        for (size_t d = 0; d < Dims; ++d)
+                        {
+                            const uintmax_t cell_index = cell % strata_per_dimension;
+                            cell /= strata_per_dimension;
+                            x[d] = box.lower[d] + (static_cast<double>(cell_index) + rnd_gen.next_double()) * width[d];
+                        }
+                    }
+
+                    const double value = static_cast<double>(f(x));
+                    stream_sum += value;
+                    local.sum_of_squares += value * value;
+                }
+
+                const double stream_mean = stream_sum / static_cast<double>(stream_size);
+                local.sum += stream_sum;
+                local.batch_sum += stream_mean;
+                local.batch_sum_of_squares += stream_mean * stream_mean;
+                local.samples += stream_size;
+                ++local.batches;
+            }
+
+            result = local;
+        }
+
+        inline Result to_result(const Accumulator& total, double volume, bool is_stratified)
+        {
+            const double n = static_cast<double>(total.samples);
+            const double mean = n > 0 ? total.sum / n : 0.0;
+
+            double variance_of_mean;
+            if (is_stratified)
+            {
+                const double batches = static_cast<double>(total.batches);
+                const double batch_mean = total.batch_sum / batches;
+                const double batch_variance = batches > 1 ? (total.batch_sum_of_squares - batches * batch_mean * batch_mean) / (batches - 1) : 0.0;
+                variance_of_mean = batch_variance / batches;
+            }
+            else
+            {
+                const double variance = n > 1 ? (total.sum_of_squares - n * mean * mean) / (n - 1) : 0.0;
+                variance_of_mean = n > 0 ? variance / n : 0.0;
+            }
+
+            return {volume * mean, volume * std::sqrt(std::max(variance_of_mean, 0.0)), total.samples};
+        }
+    }
+
+    // Integral of f over the box - f(const Point<Dims>&) returns a number or bool (indicator function).
+    //
+    // Samples are split into streams with their own generators TRng{seed, stream}; threads get contiguous ranges of streams,
+    // accumulate into padded per-thread accumulators and the results are reduced once at the end.
+    // With stratified sampling the standard error is computed from stream estimates (batch means),
+    // because samples within a stream are no longer independent.
+    template <typename TRng = Philox4x32Rng, size_t Dims, typename TIntegrand>
+    Result integrate(TIntegrand f, const Box<Dims>& box, const Options& options = {})
+    {
+        const uint32_t strata_per_dimension = std::max(options.strata_per_dimension, 1u);
+        const uintmax_t stream_size = Details::samples_per_stream<Dims>(strata_per_dimension);
+        const uint64_t streams_count = std::max<uintmax_t>((options.samples + stream_size - 1) / stream_size, 1);
+        const uint32_t threads_count = static_cast<uint32_t>(std::clamp<uint64_t>(options.threads_count, 1, streams_count));
+
+        std::vector<Accumulator> accumulators(threads_count);
+        {
+            std::vector<std::jthread> threads;
+            threads.reserve(threads_count);
+
+            for (uint32_t i = 0; i < threads_count; ++i)
+            {
+                const uint64_t first_stream = streams_count * i / threads_count;
+                const uint64_t last_stream = streams_count * (i + 1) / threads_count;
+
+                threads.emplace_back([&, first_stream, last_stream, i] {
+                    TIntegrand thread_f = f; // every thread has its own copy of the callable
+                    Details::integrate_streams<TRng>(thread_f, box, options.seed, strata_per_dimension, first_stream, last_stream, accumulators[i]);
+                });
+            }
+        }
+
+        Accumulator total;
+        for (const auto& accumulator : accumulators)
+            total += accumulator;
+
+        return Details::to_result(total, box.volume(), strata_per_dimension > 1);
+    }
+
+    struct AdaptiveOptions
+    {
+        double tolerance = 1e-4; // requested half-width of the confidence interval
+        double z = 1.96;         // quantile of the normal distribution - 1.96 for 95% confidence
+        uintmax_t min_samples = 1'000'000; // before the first check of the interval - the variance estimate needs some samples
+        std::chrono::milliseconds time_budget{10'000};
+        uint32_t threads_count = std::max(std::thread::hardware_concurrency(), 1u);
+        uint64_t seed = 2024;
+        uint32_t strata_per_dimension = 1;
+    };
+
+    struct AdaptiveResult
+    {
+        double estimate;
+        double standard_error;
+        double half_width; // of the confidence interval: estimate +- half_width
+        uintmax_t samples;
+        bool is_converged; // false - stopped by the time budget
+    };
+
+    // Integrates until the confidence interval is narrower than the tolerance or the time budget expires.
+    //
+    // Workers take the next stream from a shared counter, integrate it and report its sums to the coordinator (calling thread),
+    // which keeps the running totals and stops all workers through a common std::stop_source.
+    // A worker finishes its current stream after the stop - at most one stream per thread beyond the stopping point.
+    template <typename TRng = Philox4x32Rng, size_t Dims, typename TIntegrand>
+    AdaptiveResult integrate_adaptive(TIntegrand f, const Box<Dims>& box, const AdaptiveOptions& options = {})
+    {
+        const uint32_t strata_per_dimension = std::max(options.strata_per_dimension, 1u);
+        const uint32_t threads_count = std::max(options.threads_count, 1u);
+        const double volume = box.volume();
+        const auto deadline = std::chrono::steady_clock::now() + options.time_budget;
+
+        std::mutex totals_mutex;
+        std::condition_variable round_reported;
+        Accumulator total;
+        uintmax_t rounds_count = 0;
+
+        std::atomic<uint64_t> next_stream{0};
+        std::stop_source stop;
+
+        auto is_precise = [&] {
+            if (total.samples < options.min_samples || total.batches < 2)
+                return false;
+            return options.z * Details::to_result(total, volume, strata_per_dimension > 1).standard_error <= options.tolerance;
+        };
+
+        {
+            std::vector<std::jthread> threads;
+            threads.reserve(threads_count);
+
+            for (uint32_t i = 0; i < threads_count; ++i)
+            {
+                threads.emplace_back([&, stop_token = stop.get_token()] {
+                    TIntegrand thread_f = f;
+
+                    while (!stop_token.stop_requested())
+                    {
+                        const uint64_t stream = next_stream.fetch_add(1, std::memory_order_relaxed);
+
+                        Accumulator round;
+                        Details::integrate_streams<TRng>(thread_f, box, options.seed, strata_per_dimension, stream, stream + 1, round);
+
+                        {
+                            std::lock_guard lk{totals_mutex};
+                            total += round;
+                            ++rounds_count;
+                        }
+                        round_reported.notify_one();
+                    }
+                });
+            }
+
+            std::unique_lock lk{totals_mutex};
+            for (uintmax_t checked_rounds = 0; !stop.stop_requested();)
+            {
+                const bool is_reported = round_reported.wait_until(lk, deadline, [&] { return rounds_count > checked_rounds; });
+                checked_rounds = rounds_count;
+
+                if (!is_reported || is_precise())
+                    stop.request_stop();
+            }
+        } // joins workers - their last rounds are included in totals
+
+        const Result result = Details::to_result(total, volume, strata_per_dimension > 1);
+        const double half_width = options.z * result.standard_error;
+
+        return {result.estimate, result.standard_error, half_width, result.samples, total.batches >= 2 && half_width <= options.tolerance};
+    }
+}
+
+#endif // MONTE_CARLO_HPP
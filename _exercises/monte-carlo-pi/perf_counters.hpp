@@ -0,0 +1,163 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum class PerfEvent
+{
+    cycles,
+    instructions,
+    l1d_misses,
+    llc_misses,
+    hitm // loads served by a modified cache line of another core - the cost of false sharing
+};
+
+constexpr size_t perf_events_count = 5;
+constexpr std::array<std::string_view, perf_events_count> perf_event_names = {"cycles", "instructions", "l1d_misses", "llc_misses", "hitm"};
+
+// raw event counting HITM loads - MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM (XSNP_FWD since Ice Lake) of Intel cores, 0 - not available
+inline uint64_t default_hitm_event()
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_is("intel"))
+        return 0x04D2;
+#endif
+    return 0;
+}
+
+// counted values - empty when the event could not be opened (unsupported by the CPU, virtual machine, perf_event_paranoid)
+struct PerfReading
+{
+    std::array<std::optional<double>, perf_events_count> values;
+
+    const std::optional<double>& operator[](PerfEvent event) const
+    {
+        return values[static_cast<size_t>(event)];
+    }
+
+    bool has_values() const
+    {
+        for (const auto& value : values)
+            if (value)
+                return true;
+        return false;
+    }
+
+    std::optional<double> ipc() const
+    {
+        const auto& cycles = (*this)[PerfEvent::cycles];
+        const auto& instructions = (*this)[PerfEvent::instructions];
+        if (!cycles || !instructions || *cycles == 0)
+            return std::nullopt;
+        return *instructions / *cycles;
+    }
+};
+
+// Hardware counters of the whole process for the duration of start() - stop().
+//
+// Counters are inherited by threads created after start(), and counts of a thread are added when the thread exits,
+// so threads of a pool have to be created and joined within start() - stop() (see stop_persistent_workers() in pi.cpp).
+class PerfCounters
+{
+public:
+    explicit PerfCounters(uint64_t hitm_event = default_hitm_event())
+    {
+#if defined(__linux__)
+        fds_[static_cast<size_t>(PerfEvent::cycles)] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds_[static_cast<size_t>(PerfEvent::instructions)] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds_[static_cast<size_t>(PerfEvent::l1d_misses)] = open_event(PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        fds_[static_cast<size_t>(PerfEvent::llc_misses)] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        if (hitm_event != 0)
+            fds_[static_cast<size_t>(PerfEvent::hitm)] = open_event(PERF_TYPE_RAW, hitm_event);
+#else
+        (void)hitm_event;
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+        for (int fd : fds_)
+            if (fd != -1)
+                close(fd);
+#endif
+    }
+
+    bool is_available() const
+    {
+        for (int fd : fds_)
+            if (fd != -1)
+                return true;
+        return false;
+    }
+
+    void start()
+    {
+#if defined(__linux__)
+        for (int fd : fds_)
+            if (fd != -1)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+    }
+
+    PerfReading stop()
+    {
+        PerfReading reading;
+#if defined(__linux__)
+        for (size_t i = 0; i < perf_events_count; ++i)
+        {
+            if (fds_[i] == -1)
+                continue;
+
+            ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+
+            uint64_t value[3]; // value, time enabled, time running
+            if (read(fds_[i], value, sizeof(value)) != sizeof(value) || value[2] == 0)
+                continue;
+
+            // the kernel multiplexes events when there are more than hardware counters - scaled to the whole time
+            reading.values[i] = static_cast<double>(value[0]) * static_cast<double>(value[1]) / static_cast<double>(value[2]);
+        }
+#endif
+        return reading;
+    }
+
+private:
+    std::array<int, perf_events_count> fds_{-1, -1, -1, -1, -1};
+
+#if defined(__linux__)
+    static int open_event(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC)); // this process, any CPU
+    }
+#endif
+};
+
+#endif // PERF_COUNTERS_HPP
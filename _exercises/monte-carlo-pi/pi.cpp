@@ -1,16 +1,35 @@
+#include "benchmark.hpp"
+#include "cache_line.hpp"
+#include "monte_carlo.hpp"
+#include "rng_policies.hpp"
+#include "simd_hits.hpp"
+#include "thread_pool.hpp"
+
 #include <atomic>
 #include <chrono>
 #include <cstdlib>
-#include <ctime>
+#include <functional>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <new>
 #include <numeric>
+#include <memory>
+#include <optional>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <thread>
-#include <future>
+#include <vector>
 
-using namespace std;
+#if defined(PI_WITH_PARALLEL_STL)
+#include <execution>
+#include <tbb/global_control.h>
+#endif
 
-const uintmax_t N = 100'000'000;
+using namespace std;
 
 void calculate_hits(uintmax_t N, uintmax_t& hits)
 {
@@ -99,71 +118,132 @@ void calculate_hits_atomic(uintmax_t N, std::atomic<uintmax_t>& hits)
     //hits.fetch_add(local_counter, std::memory_order_relaxed);
 }
 
-void single_thread_pi()
+struct Hits
 {
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+    alignas(cache_line_size) uintmax_t value;
+};
 
-    cout << "Pi (single thread)!" << endl;
-    const auto start = chrono::high_resolution_clock::now();
+void calculate_hits_with_padding(uintmax_t N, Hits& hits)
+{
+    const size_t seed = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    std::mt19937_64 rnd_gen{seed};
+    std::uniform_real_distribution<double> rnd_distr{0.0, 1.0};
 
-    uintmax_t hits = 0;
+    for (uintmax_t n = 0; n < N; ++n)
+    {
+        double x = rnd_distr(rnd_gen);
+        double y = rnd_distr(rnd_gen);
+        if (x * x + y * y <= 1)
+            ++(hits.value); // hot-loop
+    }
+}
 
-    calculate_hits(N, hits);
+uintmax_t calculate_hits(uintmax_t N)
+{
+    const size_t seed = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    std::mt19937_64 rnd_gen{seed};
+    std::uniform_real_distribution<double> rnd_distr{0.0, 1.0};
 
-    const double pi = static_cast<double>(hits) / N * 4;
+    uintmax_t hits{};
+    for (uintmax_t n = 0; n < N; ++n)
+    {
+        double x = rnd_distr(rnd_gen);
+        double y = rnd_distr(rnd_gen);
+        if (x * x + y * y <= 1)
+            ++hits; // hot-loop
+    }
+    return hits;
+}
 
-    const auto end = chrono::high_resolution_clock::now();
-    const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+uintmax_t calculate_hits_future(uintmax_t N)
+{
+    const size_t seed = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    std::mt19937_64 rnd_gen{seed};
+    std::uniform_real_distribution<double> rnd_distr{0.0, 1.0};
 
-    cout << "Pi = " << pi << endl;
-    cout << "Elapsed (single thread) = " << elapsed_time << "ms" << endl;
+    uintmax_t hits{};
+    for (uintmax_t n = 0; n < N; ++n)
+    {
+        double x = rnd_distr(rnd_gen);
+        double y = rnd_distr(rnd_gen);
+        if (x * x + y * y <= 1)
+            ++hits; // hot-loop
+    }
+    return hits;
 }
 
-void multi_thread_pi()
+// random numbers are generated in batches by 8 xoshiro lanes, points are tested 4 or 8 at a time
+uintmax_t calculate_hits_simd(uintmax_t N)
 {
-    const auto threads_count{std::max(std::thread::hardware_concurrency(), 1u)};
+    const size_t seed = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    Xoshiro256PlusX8 rnd_gen{seed};
 
-    std::vector<std::thread> threads(threads_count);
-    std::vector<uintmax_t> hits(threads_count);
-    const uintmax_t n_per_thread = N / threads_count;
+    return count_hits_simd(rnd_gen, N);
+}
 
-    std::cout << "Pi (multi thread)! Number of threads: " << threads_count << std::endl;
-    const auto start = chrono::high_resolution_clock::now();
+// Reproducible estimate: points are split into fixed streams, every stream has its own generator TRng{seed, stream}.
+// Threads get contiguous ranges of streams, so the estimate depends only on the seed - not on the number of threads.
+const uintmax_t points_per_stream = 1 << 20;
 
-    for (uint32_t i{0}; i < threads_count; i++)
+template <typename TRng>
+uintmax_t calculate_hits_in_stream(uint64_t seed, uint64_t stream, uintmax_t N)
+{
+    TRng rnd_gen{seed, stream};
+
+    uintmax_t hits{};
+    for (uintmax_t n = 0; n < N; ++n)
     {
-        threads[i] = std::thread(&calculate_hits, static_cast<uintmax_t>(n_per_thread), std::ref(hits[i]));
+        double x = rnd_gen.next_double();
+        double y = rnd_gen.next_double();
+        if (x * x + y * y <= 1)
+            ++hits; // hot-loop
     }
+    return hits;
+}
 
-    for (uint32_t i{0}; i < threads_count; i++)
+template <>
+uintmax_t calculate_hits_in_stream<Xoshiro256PlusX8>(uint64_t seed, uint64_t stream, uintmax_t N)
+{
+    Xoshiro256PlusX8 rnd_gen{seed, stream};
+    return count_hits_simd(rnd_gen, N);
+}
+
+template <typename TRng>
+uintmax_t calculate_hits_in_streams(uintmax_t N, uint64_t seed, uint64_t first_stream, uint64_t last_stream)
+{
+    uintmax_t hits{};
+    for (uint64_t stream = first_stream; stream < last_stream; ++stream)
     {
-        threads[i].join();
+        const uintmax_t stream_size = std::min(points_per_stream, N - stream * points_per_stream);
+        hits += calculate_hits_in_stream<TRng>(seed, stream, stream_size);
     }
+    return hits;
+}
 
-    uintmax_t total_hits = std::accumulate(hits.begin(), hits.end(), uintmax_t{});
-    const double pi = static_cast<double>(total_hits) / N * 4;
+// number of points computed by thread i when N points are split among threads_count threads
+uintmax_t points_for_thread(uintmax_t N, uint32_t threads_count, uint32_t i)
+{
+    return N / threads_count + (i < N % threads_count ? 1 : 0);
+}
 
-    const auto end = chrono::high_resolution_clock::now();
-    const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+//////////////////////////////////////////////////////////////////////////////
+// strategies - every strategy returns number of hits among N points
 
-    cout << "Pi = " << pi << endl;
-    cout << "Elapsed (" << threads_count << " threads) = " << elapsed_time << "ms" << endl;
+uintmax_t single_thread_pi(uintmax_t N, uint32_t /*threads_count*/)
+{
+    uintmax_t hits = 0;
+    calculate_hits(N, hits);
+    return hits;
 }
 
-void multi_thread_pi_with_local_counter()
+uintmax_t multi_thread_pi(uintmax_t N, uint32_t threads_count)
 {
-    const auto threads_count{std::max(std::thread::hardware_concurrency(), 1u)};
-
     std::vector<std::thread> threads(threads_count);
     std::vector<uintmax_t> hits(threads_count);
-    const uintmax_t n_per_thread = N / threads_count;
-
-    std::cout << "Pi (multi thread - local counter)! Number of threads: " << threads_count << std::endl;
-    const auto start = chrono::high_resolution_clock::now();
 
     for (uint32_t i{0}; i < threads_count; i++)
     {
-        threads[i] = std::thread(&calculate_hits_with_local_counter, static_cast<uintmax_t>(n_per_thread), std::ref(hits[i]));
+        threads[i] = std::thread(static_cast<void (*)(uintmax_t, uintmax_t&)>(&calculate_hits), points_for_thread(N, threads_count, i), std::ref(hits[i]));
     }
 
     for (uint32_t i{0}; i < threads_count; i++)
@@ -171,50 +251,35 @@ void multi_thread_pi_with_local_counter()
         threads[i].join();
     }
 
-    uintmax_t total_hits = std::accumulate(hits.begin(), hits.end(), uintmax_t{});
-    const double pi = static_cast<double>(total_hits) / N * 4;
-
-    const auto end = chrono::high_resolution_clock::now();
-    const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
-
-    cout << "Pi = " << pi << endl;
-    cout << "Elapsed (" << threads_count << " threads - local counter) = " << elapsed_time << "ms" << endl;
+    return std::accumulate(hits.begin(), hits.end(), uintmax_t{});
 }
 
-struct Hits
+uintmax_t multi_thread_pi_with_local_counter(uintmax_t N, uint32_t threads_count)
 {
-    alignas(std::hardware_destructive_interference_size) uintmax_t value;
-};
+    std::vector<std::thread> threads(threads_count);
+    std::vector<uintmax_t> hits(threads_count);
 
-void calculate_hits_with_padding(uintmax_t N, Hits& hits)
-{
-    const size_t seed = std::hash<std::thread::id>{}(std::this_thread::get_id());
-    std::mt19937_64 rnd_gen{seed};
-    std::uniform_real_distribution<double> rnd_distr{0.0, 1.0};
+    for (uint32_t i{0}; i < threads_count; i++)
+    {
+        threads[i] = std::thread(&calculate_hits_with_local_counter, points_for_thread(N, threads_count, i), std::ref(hits[i]));
+    }
 
-    for (uintmax_t n = 0; n < N; ++n)
+    for (uint32_t i{0}; i < threads_count; i++)
     {
-        double x = rnd_distr(rnd_gen);
-        double y = rnd_distr(rnd_gen);
-        if (x * x + y * y <= 1)
-            ++(hits.value); // hot-loop
+        threads[i].join();
     }
+
+    return std::accumulate(hits.begin(), hits.end(), uintmax_t{});
 }
 
-void multi_thread_pi_with_padding()
+uintmax_t multi_thread_pi_with_padding(uintmax_t N, uint32_t threads_count)
 {
-    const auto threads_count{std::max(std::thread::hardware_concurrency(), 1u)};
-
     std::vector<std::thread> threads(threads_count);
     std::vector<Hits> hits(threads_count);
-    const uintmax_t n_per_thread = N / threads_count;
-
-    std::cout << "Pi (multi thread - padding)! Number of threads: " << threads_count << std::endl;
-    const auto start = chrono::high_resolution_clock::now();
 
     for (uint32_t i{0}; i < threads_count; i++)
     {
-        threads[i] = std::thread(&calculate_hits_with_padding, static_cast<uintmax_t>(n_per_thread), std::ref(hits[i]));
+        threads[i] = std::thread(&calculate_hits_with_padding, points_for_thread(N, threads_count, i), std::ref(hits[i]));
     }
 
     for (uint32_t i{0}; i < threads_count; i++)
@@ -222,32 +287,19 @@ void multi_thread_pi_with_padding()
         threads[i].join();
     }
 
-    uintmax_t total_hits = std::accumulate(hits.begin(), hits.end(), uintmax_t{}, [](uintmax_t red, Hits arg) { return red + arg.value; });
-    const double pi = static_cast<double>(total_hits) / N * 4;
-
-    const auto end = chrono::high_resolution_clock::now();
-    const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
-
-    cout << "Pi = " << pi << endl;
-    cout << "Elapsed (" << threads_count << " threads - padding) = " << elapsed_time << "ms" << endl;
+    return std::accumulate(hits.begin(), hits.end(), uintmax_t{}, [](uintmax_t red, Hits arg) { return red + arg.value; });
 }
 
-void multi_thread_pi_with_mutex()
+uintmax_t multi_thread_pi_with_mutex(uintmax_t N, uint32_t threads_count)
 {
-    const auto threads_count{std::max(std::thread::hardware_concurrency(), 1u)};
-
     std::vector<std::thread> threads(threads_count);
-    const uintmax_t n_per_thread = N / threads_count;
-
-    std::cout << "Pi (multi thread - mutex)! Number of threads: " << threads_count << std::endl;
-    const auto start = chrono::high_resolution_clock::now();
 
     uintmax_t hits{};
     std::mutex hits_mutex;
 
     for (uint32_t i{0}; i < threads_count; i++)
     {
-        threads[i] = std::thread(&calculate_hits_with_mutex, static_cast<uintmax_t>(n_per_thread), std::ref(hits), std::ref(hits_mutex));
+        threads[i] = std::thread(&calculate_hits_with_mutex, points_for_thread(N, threads_count, i), std::ref(hits), std::ref(hits_mutex));
     }
 
     for (uint32_t i{0}; i < threads_count; i++)
@@ -255,138 +307,478 @@ void multi_thread_pi_with_mutex()
         threads[i].join();
     }
 
-    const double pi = static_cast<double>(hits) / N * 4;
+    return hits;
+}
 
-    const auto end = chrono::high_resolution_clock::now();
-    const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+uintmax_t multi_thread_pi_with_atomic(uintmax_t N, uint32_t threads_count)
+{
+    std::vector<std::thread> threads(threads_count);
+    std::atomic<uintmax_t> hits{};
+
+    for (uint32_t i{0}; i < threads_count; i++)
+    {
+        threads[i] = std::thread(&calculate_hits_atomic, points_for_thread(N, threads_count, i), std::ref(hits));
+    }
 
-    cout << "Pi = " << pi << endl;
-    cout << "Elapsed (" << threads_count << " threads) = " << elapsed_time << "ms" << endl;
+    for (uint32_t i{0}; i < threads_count; i++)
+    {
+        threads[i].join();
+    }
+
+    return hits;
 }
 
-void multi_thread_pi_with_atomic()
+uintmax_t multi_thread_pi_with_futures(uintmax_t N, uint32_t threads_count)
 {
-    const auto threads_count{std::max(std::thread::hardware_concurrency(), 1u)};
-    const uintmax_t n_per_thread = N / threads_count;
+    std::vector<std::future<uintmax_t>> futures(threads_count);
 
-    std::vector<std::thread> threads(threads_count);
-    std::atomic<uintmax_t> hits;
+    for (uint32_t i{0}; i < threads_count; i++)
+    {
+        // futures[i] = std::async(std::launch::async, static_cast<uintmax_t(*)(uintmax_t)>(&calculate_hits), n_per_thread);
+        futures[i] = std::async(std::launch::async, [n = points_for_thread(N, threads_count, i)] { return calculate_hits_future(n); });
+    }
+
+    return std::accumulate(futures.begin(), futures.end(), uintmax_t{}, [](uintmax_t sum, auto& f) { return sum + f.get(); });
+}
+
+uintmax_t single_thread_pi_simd(uintmax_t N, uint32_t /*threads_count*/)
+{
+    return calculate_hits_simd(N);
+}
 
-    std::cout << "Pi (multi thread - atomic)! Number of threads: " << threads_count << std::endl;
-    const auto start = chrono::high_resolution_clock::now();
+uintmax_t multi_thread_pi_simd(uintmax_t N, uint32_t threads_count)
+{
+    std::vector<std::future<uintmax_t>> futures(threads_count);
 
     for (uint32_t i{0}; i < threads_count; i++)
     {
-        threads[i] = std::thread(&calculate_hits_atomic, n_per_thread, std::ref(hits));
+        futures[i] = std::async(std::launch::async, [n = points_for_thread(N, threads_count, i)] { return calculate_hits_simd(n); });
     }
 
+    return std::accumulate(futures.begin(), futures.end(), uintmax_t{}, [](uintmax_t sum, auto& f) { return sum + f.get(); });
+}
+
+template <typename TRng>
+uintmax_t multi_thread_pi_reproducible(uintmax_t N, uint32_t threads_count, uint64_t seed)
+{
+    const uint64_t streams_count = (N + points_per_stream - 1) / points_per_stream;
+
+    std::vector<std::future<uintmax_t>> futures(threads_count);
+
     for (uint32_t i{0}; i < threads_count; i++)
     {
-        threads[i].join();
+        const uint64_t first_stream = streams_count * i / threads_count;
+        const uint64_t last_stream = streams_count * (i + 1) / threads_count;
+        futures[i] = std::async(std::launch::async, [=] { return calculate_hits_in_streams<TRng>(N, seed, first_stream, last_stream); });
     }
 
-    const double pi = static_cast<double>(hits) / N * 4;
+    return std::accumulate(futures.begin(), futures.end(), uintmax_t{}, [](uintmax_t sum, auto& f) { return sum + f.get(); });
+}
 
-    const auto end = chrono::high_resolution_clock::now();
-    const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+// Pool and parallel STL variants run the same workload as multi_thread_pi_reproducible - streams of points -
+// so results are identical and only the way of running the work differs.
 
-    cout << "Pi = " << pi << endl;
-    cout << "Elapsed (" << threads_count << " threads - atomic) = " << elapsed_time << "ms" << endl;
+std::unique_ptr<ThreadPool<>>& thread_pool_instance()
+{
+    static std::unique_ptr<ThreadPool<>> pool;
+    return pool;
 }
 
-uintmax_t calculate_hits(uintmax_t N)
+// workers are created once and reused by all repetitions - thread creation is not measured
+ThreadPool<>& thread_pool(uint32_t threads_count)
 {
-    const size_t seed = std::hash<std::thread::id>{}(std::this_thread::get_id());
-    std::mt19937_64 rnd_gen{seed};
-    std::uniform_real_distribution<double> rnd_distr{0.0, 1.0};
+    std::unique_ptr<ThreadPool<>>& pool = thread_pool_instance();
 
-    uintmax_t hits{};
-    for (uintmax_t n = 0; n < N; ++n)
+    if (!pool || pool->size() != threads_count)
     {
-        double x = rnd_distr(rnd_gen);
-        double y = rnd_distr(rnd_gen);
-        if (x * x + y * y <= 1)
-            ++hits; // hot-loop
+        pool.reset();
+        pool = std::make_unique<ThreadPool<>>(threads_count);
     }
-    return hits;
+
+    return *pool;
 }
 
-uintmax_t calculate_hits_future(uintmax_t N)
+template <typename TRng>
+uintmax_t thread_pool_pi(uintmax_t N, uint32_t threads_count, uint64_t seed)
 {
-    const size_t seed = std::hash<std::thread::id>{}(std::this_thread::get_id());
-    std::mt19937_64 rnd_gen{seed};
-    std::uniform_real_distribution<double> rnd_distr{0.0, 1.0};
+    const uint64_t streams_count = (N + points_per_stream - 1) / points_per_stream;
+    const uint64_t tasks_count = std::min<uint64_t>(streams_count, 4 * threads_count); // a few chunks per worker balance the load
 
-    uintmax_t hits{};
-    for (uintmax_t n = 0; n < N; ++n)
+    ThreadPool<>& pool = thread_pool(threads_count);
+    std::vector<std::future<uintmax_t>> futures;
+    futures.reserve(tasks_count);
+
+    for (uint64_t i{0}; i < tasks_count; i++)
     {
-        double x = rnd_distr(rnd_gen);
-        double y = rnd_distr(rnd_gen);
-        if (x * x + y * y <= 1)
-            ++hits; // hot-loop
+        const uint64_t first_stream = streams_count * i / tasks_count;
+        const uint64_t last_stream = streams_count * (i + 1) / tasks_count;
+        futures.push_back(pool.submit([=] { return calculate_hits_in_streams<TRng>(N, seed, first_stream, last_stream); }));
     }
-    return hits;
+
+    return std::accumulate(futures.begin(), futures.end(), uintmax_t{}, [](uintmax_t sum, auto& f) { return sum + f.get(); });
 }
 
-void multi_thread_pi_with_futures()
+#if defined(PI_WITH_PARALLEL_STL)
+template <typename TRng>
+uintmax_t parallel_stl_pi(uintmax_t N, uint32_t threads_count, uint64_t seed)
 {
-    const auto threads_count{std::max(std::thread::hardware_concurrency(), 1u)};
-    const uintmax_t n_per_thread = N / threads_count;
+    const uint64_t streams_count = (N + points_per_stream - 1) / points_per_stream;
 
-    std::cout << "Pi (multi thread - futures)! Number of threads: " << threads_count << std::endl;
-    const auto start = chrono::high_resolution_clock::now();
+    std::vector<uint64_t> streams(streams_count);
+    std::iota(streams.begin(), streams.end(), uint64_t{0});
 
-    std::vector<std::future<uintmax_t>> futures(threads_count);
+    simd_variant_name(); // initializes CPU dispatch here - no locking of a static inside par_unseq calls
 
-    for (uint32_t i{0}; i < threads_count; i++)
+    tbb::global_control max_threads{tbb::global_control::max_allowed_parallelism, threads_count}; // the same number of threads as other strategies
+
+    return std::transform_reduce(std::execution::par_unseq, streams.begin(), streams.end(), uintmax_t{}, std::plus<>{},
+        [=](uint64_t stream) { return calculate_hits_in_streams<TRng>(N, seed, stream, stream + 1); });
+}
+#endif
+
+// Threads of the pool and TBB workers outlive a run. PerfCounters count only threads created after start()
+// and add their counts when they exit, so a counted run has to start and end without these threads.
+// Returns false when TBB workers could not be stopped - their counts would be missing.
+bool stop_persistent_workers()
+{
+    thread_pool_instance().reset();
+
+#if defined(PI_WITH_PARALLEL_STL)
+    tbb::task_scheduler_handle handle{tbb::attach{}};
+    return tbb::finalize(handle, std::nothrow);
+#else
+    return true;
+#endif
+}
+
+struct PiEstimate
+{
+    double pi;
+    uintmax_t samples; // drawn - the integration engine rounds N up to whole streams
+};
+
+// pi / 4 as the integral of the indicator function of the unit circle over the unit square
+template <typename TRng>
+PiEstimate integration_pi(uintmax_t N, uint32_t threads_count, uint64_t seed, uint32_t strata_per_dimension = 1)
+{
+    const MonteCarlo::Box<2> unit_square{{0.0, 0.0}, {1.0, 1.0}};
+    const auto inside_circle = [](const MonteCarlo::Point<2>& p) { return p[0] * p[0] + p[1] * p[1] <= 1.0; };
+
+    const MonteCarlo::Result result = MonteCarlo::integrate<TRng>(inside_circle, unit_square, {N, threads_count, seed, strata_per_dimension});
+    return {4 * result.estimate, result.samples};
+}
+
+// pi as the integral of the indicator function of the unit circle over [-1, 1]^2 - tolerance applies directly to pi
+MonteCarlo::AdaptiveResult adaptive_pi(double tolerance, std::chrono::milliseconds time_budget, uint32_t threads_count, uint64_t seed)
+{
+    const MonteCarlo::Box<2> square{{-1.0, -1.0}, {1.0, 1.0}};
+    const auto inside_circle = [](const MonteCarlo::Point<2>& p) { return p[0] * p[0] + p[1] * p[1] <= 1.0; };
+
+    MonteCarlo::AdaptiveOptions options;
+    options.tolerance = tolerance;
+    options.time_budget = time_budget;
+    options.threads_count = threads_count;
+    options.seed = seed;
+
+    return MonteCarlo::integrate_adaptive<Philox4x32Rng>(inside_circle, square, options);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// benchmark driver
+
+using PiEstimation = std::function<PiEstimate(uintmax_t N, uint32_t threads_count)>;
+
+// strategies counting hits inside the circle - exactly N points
+PiEstimation from_hits(std::function<uintmax_t(uintmax_t N, uint32_t threads_count)> count_hits)
+{
+    return [count_hits](uintmax_t N, uint32_t threads_count) { return PiEstimate{static_cast<double>(count_hits(N, threads_count)) / N * 4, N}; };
+}
+
+struct Strategy
+{
+    std::string name;
+    bool is_multi_threaded;
+    PiEstimation run;
+};
+
+std::vector<Strategy> all_strategies(uint64_t seed)
+{
+    return {
+        {"single_thread", false, from_hits(&single_thread_pi)},
+        {"multi_thread", true, from_hits(&multi_thread_pi)},
+        {"local_counter", true, from_hits(&multi_thread_pi_with_local_counter)},
+        {"padding", true, from_hits(&multi_thread_pi_with_padding)},
+        {"mutex", true, from_hits(&multi_thread_pi_with_mutex)},
+        {"atomic", true, from_hits(&multi_thread_pi_with_atomic)},
+        {"futures", true, from_hits(&multi_thread_pi_with_futures)},
+        {"single_thread_simd", false, from_hits(&single_thread_pi_simd)},
+        {"simd", true, from_hits(&multi_thread_pi_simd)},
+        {"reproducible_philox", true, from_hits([seed](uintmax_t N, uint32_t threads_count) { return multi_thread_pi_reproducible<Philox4x32Rng>(N, threads_count, seed); })},
+        {"reproducible_mt19937", true, from_hits([seed](uintmax_t N, uint32_t threads_count) { return multi_thread_pi_reproducible<Mt19937Rng>(N, threads_count, seed); })},
+        {"reproducible_simd", true, from_hits([seed](uintmax_t N, uint32_t threads_count) { return multi_thread_pi_reproducible<Xoshiro256PlusX8>(N, threads_count, seed); })},
+        {"thread_pool_mt19937", true, from_hits([seed](uintmax_t N, uint32_t threads_count) { return thread_pool_pi<Mt19937Rng>(N, threads_count, seed); })},
+        {"thread_pool_simd", true, from_hits([seed](uintmax_t N, uint32_t threads_count) { return thread_pool_pi<Xoshiro256PlusX8>(N, threads_count, seed); })},
+#if defined(PI_WITH_PARALLEL_STL)
+        {"par_unseq_mt19937", true, from_hits([seed](uintmax_t N, uint32_t threads_count) { return parallel_stl_pi<Mt19937Rng>(N, threads_count, seed); })},
+        {"par_unseq_simd", true, from_hits([seed](uintmax_t N, uint32_t threads_count) { return parallel_stl_pi<Xoshiro256PlusX8>(N, threads_count, seed); })},
+#endif
+        {"integration_philox", true, [seed](uintmax_t N, uint32_t threads_count) { return integration_pi<Philox4x32Rng>(N, threads_count, seed); }},
+        {"integration_mt19937", true, [seed](uintmax_t N, uint32_t threads_count) { return integration_pi<Mt19937Rng>(N, threads_count, seed); }},
+        {"integration_stratified", true, [seed](uintmax_t N, uint32_t threads_count) { return integration_pi<Philox4x32Rng>(N, threads_count, seed, 16); }},
+    };
+}
+
+struct Options
+{
+    std::vector<std::string> strategies; // empty - all
+    uintmax_t N = 100'000'000;
+    uint32_t threads_count = std::max(std::thread::hardware_concurrency(), 1u);
+    int repetitions = 5;
+    int warmup = 1;
+    uint64_t seed = 2024;
+    bool is_json = false;
+    bool is_list = false;
+    bool is_perf = false;
+    bool is_scaling = false;
+    uint32_t max_threads_count = 2 * std::max(std::thread::hardware_concurrency(), 1u); // of the scaling mode
+    uint64_t hitm_event = default_hitm_event();
+    double tolerance = 0.0; // > 0 - adaptive mode
+    std::chrono::milliseconds time_budget{10'000};
+};
+
+void print_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --list                  prints names of strategies\n"
+              << "  --strategies a,b,...    strategies to run (default: all)\n"
+              << "  --n N                   number of points, e.g. 1e8 (default: 100000000)\n"
+              << "  --threads T             threads of multi-threaded strategies (default: hardware concurrency)\n"
+              << "  --reps R                measured repetitions (default: 5)\n"
+              << "  --warmup W              runs before measurement (default: 1)\n"
+              << "  --seed S                seed of reproducible strategies (default: 2024)\n"
+              << "  --format table|json     output format (default: table)\n"
+              << "  --scaling               runs multi-threaded strategies with 1, 2, 4, ... threads - speedup, efficiency, Karp-Flatt metric\n"
+              << "  --max-threads M         largest thread count of the scaling mode (default: 2x hardware concurrency)\n"
+              << "  --perf                  hardware counters of one additional run of every strategy (Linux perf_event_open)\n"
+              << "  --hitm-event CONFIG     raw perf event counting HITM loads, e.g. 0x04d2, 0 - none (default: by CPU)\n"
+              << "  --tolerance E           adaptive mode: samples until the 95% confidence interval of pi is narrower than +-E\n"
+              << "                          (integration over [-1, 1]^2 - not with --strategies, --scaling or --perf)\n"
+              << "  --time-budget MS        time limit of the adaptive mode (default: 10000)\n";
+}
+
+Options parse_options(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
     {
-        // futures[i] = std::async(std::launch::async, static_cast<uintmax_t(*)(uintmax_t)>(&calculate_hits), n_per_thread);
-        futures[i] = std::async(std::launch::async, [n_per_thread] { return calculate_hits(n_per_thread); });
+        const std::string arg = argv[i];
+
+        if (arg == "--list")
+        {
+            options.is_list = true;
+            continue;
+        }
+
+        if (arg == "--perf")
+        {
+            options.is_perf = true;
+            continue;
+        }
+
+        if (arg == "--scaling")
+        {
+            options.is_scaling = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+            throw std::invalid_argument("missing value of " + arg);
+        const std::string value = argv[++i];
+
+        if (arg == "--strategies")
+        {
+            std::istringstream names{value};
+            for (std::string name; std::getline(names, name, ',');)
+                options.strategies.push_back(name);
+        }
+        else if (arg == "--n")
+            options.N = static_cast<uintmax_t>(std::stod(value));
+        else if (arg == "--threads")
+            options.threads_count = static_cast<uint32_t>(std::stoul(value));
+        else if (arg == "--reps")
+            options.repetitions = std::stoi(value);
+        else if (arg == "--warmup")
+            options.warmup = std::stoi(value);
+        else if (arg == "--seed")
+            options.seed = std::stoull(value);
+        else if (arg == "--max-threads")
+            options.max_threads_count = static_cast<uint32_t>(std::stoul(value));
+        else if (arg == "--hitm-event")
+            options.hitm_event = std::stoull(value, nullptr, 0);
+        else if (arg == "--tolerance")
+            options.tolerance = std::stod(value);
+        else if (arg == "--time-budget")
+            options.time_budget = std::chrono::milliseconds{std::stoll(value)};
+        else if (arg == "--format" && (value == "table" || value == "json"))
+            options.is_json = value == "json";
+        else
+            throw std::invalid_argument("unknown option " + arg + " " + value);
     }
-    uintmax_t sum_of_hits = std::accumulate(futures.begin(), futures.end(), uintmax_t{}, [](uintmax_t sum, auto& f) { return sum + f.get(); });
 
-    const double pi = static_cast<double>(sum_of_hits) / N * 4;
+    if (options.N == 0 || options.threads_count == 0 || options.max_threads_count == 0 || options.repetitions < 1 || options.warmup < 0)
+        throw std::invalid_argument("N, threads and repetitions must be positive");
 
-    const auto end = chrono::high_resolution_clock::now();
-    const auto elapsed_time = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+    if (options.tolerance > 0 && (!options.strategies.empty() || options.is_scaling || options.is_perf))
+        throw std::invalid_argument("adaptive mode (--tolerance) cannot be combined with --strategies, --scaling or --perf");
 
-    cout << "Pi = " << pi << endl;
-    cout << "Elapsed (" << threads_count << " threads - futures) = " << elapsed_time << "ms" << endl;
+    return options;
 }
 
-int main()
+std::vector<Strategy> select_strategies(const Options& options)
 {
-    const uintmax_t N = 100'000'000;
+    std::vector<Strategy> strategies = all_strategies(options.seed);
+    if (options.strategies.empty())
+        return strategies;
 
-    single_thread_pi();
+    std::vector<Strategy> selected;
+    for (const auto& name : options.strategies)
+    {
+        auto it = std::find_if(strategies.begin(), strategies.end(), [&name](const Strategy& s) { return s.name == name; });
+        if (it == strategies.end())
+            throw std::invalid_argument("unknown strategy " + name);
+        selected.push_back(*it);
+    }
+    return selected;
+}
 
-    std::cout << "\n----------\n"
-              << std::endl;
+// 1, 2, 4, ... max_threads_count
+std::vector<uint32_t> scaling_threads_counts(uint32_t max_threads_count)
+{
+    std::vector<uint32_t> threads_counts;
+    for (uint32_t threads_count = 1; threads_count < max_threads_count; threads_count *= 2)
+        threads_counts.push_back(threads_count);
+    threads_counts.push_back(max_threads_count);
+    return threads_counts;
+}
 
-    multi_thread_pi();
+int main(int argc, char* argv[])
+{
+    Options options;
+    std::vector<Strategy> strategies;
 
-    std::cout << "\n----------\n"
-              << std::endl;
+    try
+    {
+        options = parse_options(argc, argv);
+        strategies = select_strategies(options);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
 
-    multi_thread_pi_with_local_counter();
+    if (options.is_list)
+    {
+        for (const auto& strategy : strategies)
+            std::cout << strategy.name << "\n";
+        return 0;
+    }
 
-    std::cout << "\n----------\n"
-              << std::endl;
+    if (options.tolerance > 0)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const MonteCarlo::AdaptiveResult result = adaptive_pi(options.tolerance, options.time_budget, options.threads_count, options.seed);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (options.is_json)
+            std::cout << std::setprecision(12) << "{\"pi\": " << result.estimate << ", \"half_width\": " << result.half_width
+                      << ", \"standard_error\": " << result.standard_error << ", \"samples\": " << result.samples
+                      << ", \"converged\": " << std::boolalpha << result.is_converged << ", \"time_ms\": " << elapsed.count() << "}" << std::endl;
+        else
+            std::cout << std::setprecision(10) << "pi = " << result.estimate << " +- " << result.half_width << " (95% CI)\n"
+                      << "samples = " << result.samples << ", threads = " << options.threads_count << ", time = " << elapsed.count() << " ms"
+                      << (result.is_converged ? "" : " - time budget expired before reaching the tolerance") << "\n";
+        return 0;
+    }
 
-    multi_thread_pi_with_padding();
+    std::optional<PerfCounters> counters;
+    if (options.is_perf)
+    {
+        counters.emplace(options.hitm_event);
+        if (!counters->is_available())
+            std::cerr << "Warning: hardware counters are not available (perf_event_open failed)\n";
+    }
+
+    if (!options.is_json)
+    {
+        std::cout << "N = " << options.N << ", repetitions = " << options.repetitions << ", warm-up = " << options.warmup
+                  << ", hardware concurrency = " << std::thread::hardware_concurrency() << ", SIMD: " << simd_variant_name() << "\n\n";
 
-    std::cout << "\n----------\n"
-              << std::endl;
+        if (options.is_scaling)
+            print_scaling_header(std::cout);
+        else
+            print_table_header(std::cout);
+    }
 
-    multi_thread_pi_with_mutex();
+    std::vector<BenchmarkResult> results;
 
-    std::cout << "\n----------\n"
-              << std::endl;
+    for (const auto& strategy : strategies)
+    {
+        std::vector<uint32_t> threads_counts{strategy.is_multi_threaded ? options.threads_count : 1};
+        if (options.is_scaling)
+        {
+            if (!strategy.is_multi_threaded)
+                continue;
+            threads_counts = scaling_threads_counts(options.max_threads_count);
+        }
 
-    multi_thread_pi_with_atomic();
+        double baseline_ms = 0.0; // of 1 thread
+
+        for (uint32_t threads_count : threads_counts)
+        {
+            const auto [estimate, time] = measure(options.warmup, options.repetitions, [&] { return strategy.run(options.N, threads_count); });
+
+            results.push_back({.name = strategy.name, .threads_count = threads_count, .points = estimate.samples, .pi = estimate.pi, .time = time, .counters = {}, .scaling = std::nullopt});
+
+            if (options.is_scaling)
+            {
+                if (threads_count == 1)
+                    baseline_ms = time.median_ms;
+                results.back().scaling = compute_scaling(baseline_ms, time.median_ms, threads_count);
+            }
+
+            if (counters && counters->is_available()) // a separate run - timings are not affected by reading counters
+            {
+                bool is_complete = stop_persistent_workers();
+                counters->start();
+                strategy.run(options.N, threads_count);
+                is_complete &= stop_persistent_workers(); // workers created by the run add their counts
+                results.back().counters = counters->stop();
+
+                if (!is_complete)
+                    results.back().counters = {}; // printed as n/a
+            }
+
+            if (!options.is_json)
+            {
+                if (options.is_scaling)
+                    print_scaling_row(std::cout, results.back());
+                else
+                    print_table_row(std::cout, results.back());
+            }
+        }
+    }
+
+    if (!options.is_json && counters && counters->is_available())
+    {
+        std::cout << "\nhardware counters of one run\n";
+        print_counters_header(std::cout);
+        for (const auto& result : results)
+            print_counters_row(std::cout, result);
+    }
 
-    std::cout << "\n----------\n"
-              << std::endl;
-    
-    multi_thread_pi_with_futures();
+    if (options.is_json)
+        print_json(std::cout, results);
 }
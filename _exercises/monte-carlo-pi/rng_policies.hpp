@@ -0,0 +1,114 @@
+#ifndef RNG_POLICIES_HPP
+#define RNG_POLICIES_HPP
+
+#include <bit>
+#include <cstdint>
+#include <random>
+#include <string_view>
+
+// Generator policies for Monte Carlo strategies:
+//   TRng{seed, stream} - generator of one of independent streams of numbers
+//   next_double()      - uniform double in [0, 1)
+// The same (seed, stream) always gives the same numbers.
+
+// uniform double in [0, 1) from the upper 53 bits
+inline double to_unit_double(uint64_t bits)
+{
+    return static_cast<double>(bits >> 11) * 0x1.0p-53;
+}
+
+// std::mt19937_64 - 2.5 KB of state, streams seeded through std::seed_seq
+class Mt19937Rng
+{
+public:
+    static constexpr std::string_view name = "mt19937_64";
+
+    Mt19937Rng(uint64_t seed, uint64_t stream)
+    {
+        std::seed_seq seed_seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)};
+        rnd_gen_.seed(seed_seq);
+    }
+
+    double next_double()
+    {
+        return to_unit_double(rnd_gen_());
+    }
+
+private:
+    std::mt19937_64 rnd_gen_;
+};
+
+// Counter-based Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// The n-th block of a stream is a pure function of (seed, stream, n) - the whole state is a 16-byte counter and an 8-byte key,
+// so every stream is a non-overlapping subsequence and jumping ahead costs nothing.
+class Philox4x32Rng
+{
+public:
+    static constexpr std::string_view name = "philox4x32-10";
+
+    Philox4x32Rng(uint64_t seed, uint64_t stream)
+        : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}
+        , counter_{0, 0, static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)}
+    {
+    }
+
+    double next_double()
+    {
+        if (position_ == 2)
+        {
+            generate_block();
+            position_ = 0;
+        }
+
+        return to_unit_double(block_[position_++]);
+    }
+
+    // moves to the n-th block (2 doubles per block) of the stream
+    void discard_blocks(uint64_t n)
+    {
+        counter_[0] = static_cast<uint32_t>(n);
+        counter_[1] = static_cast<uint32_t>(n >> 32);
+        position_ = 2;
+    }
+
+private:
+    static constexpr uint32_t multiplier_0 = 0xD251'1F53;
+    static constexpr uint32_t multiplier_1 = 0xCD9E'8D57;
+    static constexpr uint32_t weyl_0 = 0x9E37'79B9;
+    static constexpr uint32_t weyl_1 = 0xBB67'AE85;
+
+    uint32_t key_[2];
+    uint32_t counter_[4]; // [0..1] - block within the stream, [2..3] - stream
+    uint64_t block_[2]{};
+    int position_ = 2;
+
+    void generate_block()
+    {
+        uint32_t c[4] = {counter_[0], counter_[1], counter_[2], counter_[3]};
+        uint32_t k[2] = {key_[0], key_[1]};
+
+        for (int round = 0; round < 10; ++round)
+        {
+            const uint64_t product_0 = uint64_t{multiplier_0} * c[0];
+            const uint64_t product_1 = uint64_t{multiplier_1} * c[2];
+
+            const uint32_t next[4] = {
+                static_cast<uint32_t>(product_1 >> 32) ^ c[1] ^ k[0],
+                static_cast<uint32_t>(product_1),
+                static_cast<uint32_t>(product_0 >> 32) ^ c[3] ^ k[1],
+                static_cast<uint32_t>(product_0)};
+
+            c[0] = next[0], c[1] = next[1], c[2] = next[2], c[3] = next[3];
+            k[0] += weyl_0;
+            k[1] += weyl_1;
+        }
+
+        block_[0] = (uint64_t{c[1]} << 32) | c[0];
+        block_[1] = (uint64_t{c[3]} << 32) | c[2];
+
+        if (++counter_[0] == 0) // 64-bit increment of the block index
+            ++counter_[1];
+    }
+};
+
+#endif // RNG_POLICIES_HPP
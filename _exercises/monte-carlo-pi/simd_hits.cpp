@@ -0,0 +1,190 @@
+#include "simd_hits.hpp"
+
+#include <bit>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PI_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    uint64_t count_hits_in_lanes(Xoshiro256PlusX8& rng, int lanes_count)
+    {
+        uint64_t hits = 0;
+        for (int lane = 0; lane < lanes_count; ++lane)
+        {
+            const double x = Xoshiro256PlusX8::to_unit_double(rng.next(lane));
+            const double y = Xoshiro256PlusX8::to_unit_double(rng.next(lane));
+            hits += (x * x + y * y <= 1.0);
+        }
+        return hits;
+    }
+
+#if defined(PI_SIMD_X86)
+    __attribute__((target("avx2"))) __m256i load_avx2(const uint64_t* lanes)
+    {
+        return _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes));
+    }
+
+    __attribute__((target("avx2"))) void store_avx2(uint64_t* lanes, __m256i v)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    }
+
+    __attribute__((target("avx2"))) __m256i next_avx2(__m256i& s0, __m256i& s1, __m256i& s2, __m256i& s3)
+    {
+        const __m256i result = _mm256_add_epi64(s0, s3);
+        const __m256i t = _mm256_slli_epi64(s1, 17);
+
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 64 - 45)); // no 64-bit rotate in AVX2
+
+        return result;
+    }
+
+    __attribute__((target("avx2"))) __m256d to_unit_avx2(__m256i bits)
+    {
+        const __m256i exponent = _mm256_set1_epi64x(0x3FF0'0000'0000'0000);
+        return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 12), exponent)), _mm256_set1_pd(1.0));
+    }
+
+    // lanes 0-3 and 4-7 are two independent AVX2 vectors - their dependency chains interleave
+    __attribute__((target("avx2"))) uint64_t count_hits_avx2(Xoshiro256PlusX8& rng, uint64_t n)
+    {
+        __m256i a0 = load_avx2(&rng.s[0][0]), a1 = load_avx2(&rng.s[1][0]), a2 = load_avx2(&rng.s[2][0]), a3 = load_avx2(&rng.s[3][0]);
+        __m256i b0 = load_avx2(&rng.s[0][4]), b1 = load_avx2(&rng.s[1][4]), b2 = load_avx2(&rng.s[2][4]), b3 = load_avx2(&rng.s[3][4]);
+
+        const __m256d one = _mm256_set1_pd(1.0);
+        __m256i hits_a = _mm256_setzero_si256();
+        __m256i hits_b = _mm256_setzero_si256();
+
+        for (uint64_t block = 0; block < n / Xoshiro256PlusX8::lanes; ++block)
+        {
+            const __m256d xa = to_unit_avx2(next_avx2(a0, a1, a2, a3));
+            const __m256d xb = to_unit_avx2(next_avx2(b0, b1, b2, b3));
+            const __m256d ya = to_unit_avx2(next_avx2(a0, a1, a2, a3));
+            const __m256d yb = to_unit_avx2(next_avx2(b0, b1, b2, b3));
+
+            const __m256d inside_a = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(xa, xa), _mm256_mul_pd(ya, ya)), one, _CMP_LE_OQ);
+            const __m256d inside_b = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(xb, xb), _mm256_mul_pd(yb, yb)), one, _CMP_LE_OQ);
+
+            // comparison gives -1 in lanes with a hit
+            hits_a = _mm256_sub_epi64(hits_a, _mm256_castpd_si256(inside_a));
+            hits_b = _mm256_sub_epi64(hits_b, _mm256_castpd_si256(inside_b));
+        }
+
+        store_avx2(&rng.s[0][0], a0), store_avx2(&rng.s[1][0], a1), store_avx2(&rng.s[2][0], a2), store_avx2(&rng.s[3][0], a3);
+        store_avx2(&rng.s[0][4], b0), store_avx2(&rng.s[1][4], b1), store_avx2(&rng.s[2][4], b2), store_avx2(&rng.s[3][4], b3);
+
+        alignas(32) uint64_t lane_hits[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lane_hits), _mm256_add_epi64(hits_a, hits_b));
+
+        return lane_hits[0] + lane_hits[1] + lane_hits[2] + lane_hits[3]
+            + count_hits_in_lanes(rng, static_cast<int>(n % Xoshiro256PlusX8::lanes));
+    }
+
+    // shifts and rotations use the zero-masking forms with all lanes selected - the plain intrinsics of GCC pass
+    // _mm512_undefined_epi32() as the merge source, which -Wmaybe-uninitialized reports after inlining
+    constexpr __mmask8 all_lanes = 0xFF;
+
+    __attribute__((target("avx512f"))) __m512i next_avx512(__m512i& s0, __m512i& s1, __m512i& s2, __m512i& s3)
+    {
+        const __m512i result = _mm512_add_epi64(s0, s3);
+        const __m512i t = _mm512_maskz_slli_epi64(all_lanes, s1, 17);
+
+        s2 = _mm512_xor_si512(s2, s0);
+        s3 = _mm512_xor_si512(s3, s1);
+        s1 = _mm512_xor_si512(s1, s2);
+        s0 = _mm512_xor_si512(s0, s3);
+        s2 = _mm512_xor_si512(s2, t);
+        s3 = _mm512_maskz_rol_epi64(all_lanes, s3, 45);
+
+        return result;
+    }
+
+    __attribute__((target("avx512f"))) __m512d to_unit_avx512(__m512i bits)
+    {
+        const __m512i exponent = _mm512_set1_epi64(0x3FF0'0000'0000'0000);
+        return _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_maskz_srli_epi64(all_lanes, bits, 12), exponent)), _mm512_set1_pd(1.0));
+    }
+
+    __attribute__((target("avx512f"))) uint64_t count_hits_avx512(Xoshiro256PlusX8& rng, uint64_t n)
+    {
+        __m512i s0 = _mm512_load_si512(rng.s[0]);
+        __m512i s1 = _mm512_load_si512(rng.s[1]);
+        __m512i s2 = _mm512_load_si512(rng.s[2]);
+        __m512i s3 = _mm512_load_si512(rng.s[3]);
+
+        const __m512d one = _mm512_set1_pd(1.0);
+        uint64_t hits = 0;
+
+        for (uint64_t block = 0; block < n / Xoshiro256PlusX8::lanes; ++block)
+        {
+            const __m512d x = to_unit_avx512(next_avx512(s0, s1, s2, s3));
+            const __m512d y = to_unit_avx512(next_avx512(s0, s1, s2, s3));
+
+            const __mmask8 inside = _mm512_cmp_pd_mask(_mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y)), one, _CMP_LE_OQ);
+            hits += static_cast<uint64_t>(std::popcount(static_cast<unsigned>(inside)));
+        }
+
+        _mm512_store_si512(rng.s[0], s0);
+        _mm512_store_si512(rng.s[1], s1);
+        _mm512_store_si512(rng.s[2], s2);
+        _mm512_store_si512(rng.s[3], s3);
+
+        return hits + count_hits_in_lanes(rng, static_cast<int>(n % Xoshiro256PlusX8::lanes));
+    }
+#endif
+
+    using CountHits = uint64_t (*)(Xoshiro256PlusX8&, uint64_t);
+
+    struct SimdVariant
+    {
+        CountHits count_hits;
+        std::string_view name;
+    };
+
+    SimdVariant select_variant()
+    {
+#if defined(PI_SIMD_X86)
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f"))
+            return {&count_hits_avx512, "avx512"};
+
+        if (__builtin_cpu_supports("avx2"))
+            return {&count_hits_avx2, "avx2"};
+#endif
+        return {&count_hits_scalar, "scalar"};
+    }
+
+    const SimdVariant& selected_variant()
+    {
+        static const SimdVariant variant = select_variant();
+        return variant;
+    }
+}
+
+uint64_t count_hits_scalar(Xoshiro256PlusX8& rng, uint64_t n)
+{
+    uint64_t hits = 0;
+    for (uint64_t block = 0; block < n / Xoshiro256PlusX8::lanes; ++block)
+        hits += count_hits_in_lanes(rng, Xoshiro256PlusX8::lanes);
+
+    return hits + count_hits_in_lanes(rng, static_cast<int>(n % Xoshiro256PlusX8::lanes));
+}
+
+uint64_t count_hits_simd(Xoshiro256PlusX8& rng, uint64_t n)
+{
+    return selected_variant().count_hits(rng, n);
+}
+
+std::string_view simd_variant_name()
+{
+    return selected_variant().name;
+}
@@ -0,0 +1,68 @@
+#ifndef SIMD_HITS_HPP
+#define SIMD_HITS_HPP
+
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+// splitmix64 - recommended for seeding of xoshiro generators
+inline uint64_t splitmix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E37'79B9'7F4A'7C15);
+    z = (z ^ (z >> 30)) * 0xBF58'476D'1CE4'E5B9;
+    z = (z ^ (z >> 27)) * 0x94D0'49BB'1331'11EB;
+    return z ^ (z >> 31);
+}
+
+// 8 independent xoshiro256+ generators with state stored lane by lane (structure of arrays),
+// so one step of all lanes maps to one AVX-512 or two AVX2 instructions per operation.
+struct Xoshiro256PlusX8
+{
+    static constexpr int lanes = 8;
+    static constexpr std::string_view name = "xoshiro256+ x8 (SIMD)";
+
+    alignas(64) uint64_t s[4][lanes];
+
+    explicit Xoshiro256PlusX8(uint64_t seed)
+    {
+        for (auto& word : s)
+            for (auto& lane : word)
+                lane = splitmix64(seed);
+    }
+
+    // generators of different streams are seeded independently - statistically, not provably, non-overlapping
+    Xoshiro256PlusX8(uint64_t seed, uint64_t stream)
+        : Xoshiro256PlusX8{seed ^ splitmix64(stream)}
+    {
+    }
+
+    uint64_t next(int lane)
+    {
+        const uint64_t result = s[0][lane] + s[3][lane];
+        const uint64_t t = s[1][lane] << 17;
+
+        s[2][lane] ^= s[0][lane];
+        s[3][lane] ^= s[1][lane];
+        s[1][lane] ^= s[2][lane];
+        s[0][lane] ^= s[3][lane];
+        s[2][lane] ^= t;
+        s[3][lane] = std::rotl(s[3][lane], 45);
+
+        return result;
+    }
+
+    // uniform double in [0, 1) - upper 52 bits become the mantissa of a double in [1, 2)
+    static double to_unit_double(uint64_t bits)
+    {
+        return std::bit_cast<double>((bits >> 12) | 0x3FF0'0000'0000'0000) - 1.0;
+    }
+};
+
+// Counts points inside the unit circle among n points - every lane generates x and y of its own points.
+// All variants consume the generators in the same order, so the result does not depend on the selected instruction set.
+uint64_t count_hits_scalar(Xoshiro256PlusX8& rng, uint64_t n);
+uint64_t count_hits_simd(Xoshiro256PlusX8& rng, uint64_t n); // variant selected at runtime for the current CPU
+
+std::string_view simd_variant_name();
+
+#endif // SIMD_HITS_HPP
@@ -0,0 +1,174 @@
+#ifndef BANK_HPP
+#define BANK_HPP
+
+#include "cache_line.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// Ledger of many accounts - balances (in minor units) are stored contiguously, one array per account field,
+// and guarded by a fixed set of striped locks instead of one mutex per account.
+//
+// Balances start at a cache line boundary and accounts sharing a cache line share a stripe,
+// so threads holding different stripes never write to the same cache line.
+class Bank
+{
+public:
+    using AccountId = uint32_t;
+
+    static constexpr size_t stripes_count = 1024;
+    static constexpr size_t accounts_per_cache_line = cache_line_size / sizeof(int64_t);
+
+    Bank(size_t accounts_count, int64_t initial_balance)
+        : balances_(accounts_count, initial_balance)
+    {
+    }
+
+    // e.g. restored from a snapshot
+    explicit Bank(const std::vector<int64_t>& balances)
+        : balances_(balances.begin(), balances.end())
+    {
+    }
+
+    Bank(const Bank&) = delete;
+    Bank& operator=(const Bank&) = delete;
+
+    size_t size() const
+    {
+        return balances_.size();
+    }
+
+    size_t memory_usage() const
+    {
+        return sizeof(*this) + balances_.capacity() * sizeof(int64_t);
+    }
+
+    // no-op hook of operations
+    struct NoCommitHook
+    {
+        void operator()() const
+        {
+        }
+    };
+
+    int64_t balance(AccountId id) const
+    {
+        std::lock_guard lk{stripe_of(id).mtx};
+        return balances_[id];
+    }
+
+    // Operations call on_commit() under the locks of their accounts once they are known to succeed, before balances change -
+    // e.g. to journal the operation in the order it is applied. An exception thrown by on_commit() cancels the operation.
+    template <typename THook = NoCommitHook>
+    void deposit(AccountId id, int64_t amount, THook on_commit = {})
+    {
+        std::lock_guard lk{stripe_of(id).mtx};
+        on_commit();
+        balances_[id] += amount;
+    }
+
+    // fails instead of overdrawing the account
+    template <typename THook = NoCommitHook>
+    bool withdraw(AccountId id, int64_t amount, THook on_commit = {})
+    {
+        std::lock_guard lk{stripe_of(id).mtx};
+        if (balances_[id] < amount)
+            return false;
+
+        on_commit();
+        balances_[id] -= amount;
+        return true;
+    }
+
+    template <typename THook = NoCommitHook>
+    bool transfer(AccountId from, AccountId to, int64_t amount, THook on_commit = {})
+    {
+        const size_t from_stripe = stripe_index(from);
+        const size_t to_stripe = stripe_index(to);
+
+        // stripes are always locked in the order of indexes - no deadlock with other transfers and the audit
+        std::unique_lock lk_first{stripes_[std::min(from_stripe, to_stripe)].mtx};
+        std::unique_lock<std::mutex> lk_second;
+        if (from_stripe != to_stripe)
+            lk_second = std::unique_lock{stripes_[std::max(from_stripe, to_stripe)].mtx};
+
+        if (balances_[from] < amount)
+            return false;
+
+        on_commit();
+        balances_[from] -= amount;
+        balances_[to] += amount;
+        return true;
+    }
+
+    // Sum of all balances as a consistent snapshot - all stripes are locked (in order), so no transfer is half-done,
+    // then chunks of the balances are summed by threads_count threads.
+    int64_t total_balance(uint32_t threads_count = std::max(std::thread::hardware_concurrency(), 1u)) const
+    {
+        const auto locks = lock_all_stripes();
+
+        threads_count = static_cast<uint32_t>(std::clamp<size_t>(threads_count, 1, std::max<size_t>(balances_.size(), 1)));
+        std::vector<int64_t> partial_sums(threads_count); // every thread writes its sum once - no false sharing in the loop
+        {
+            std::vector<std::jthread> threads;
+            for (uint32_t i = 0; i < threads_count; ++i)
+            {
+                const size_t first = balances_.size() * i / threads_count;
+                const size_t last = balances_.size() * (i + 1) / threads_count;
+
+                threads.emplace_back([this, first, last, &partial_sum = partial_sums[i]] {
+                    partial_sum = std::accumulate(balances_.begin() + first, balances_.begin() + last, int64_t{});
+                });
+            }
+        }
+
+        return std::accumulate(partial_sums.begin(), partial_sums.end(), int64_t{});
+    }
+
+    // copy of all balances as a consistent snapshot - on_locked() is called while no operation is in progress
+    template <typename THook = NoCommitHook>
+    std::vector<int64_t> balances(THook on_locked = {}) const
+    {
+        const auto locks = lock_all_stripes();
+        on_locked();
+        return std::vector<int64_t>(balances_.begin(), balances_.end());
+    }
+
+private:
+    struct alignas(cache_line_size) Stripe
+    {
+        std::mutex mtx;
+    };
+
+    std::vector<int64_t, CacheAlignedAllocator<int64_t>> balances_; // stripe_index() relies on the alignment
+    mutable std::array<Stripe, stripes_count> stripes_;
+
+    static size_t stripe_index(AccountId id)
+    {
+        return (id / accounts_per_cache_line) % stripes_count;
+    }
+
+    std::vector<std::unique_lock<std::mutex>> lock_all_stripes() const
+    {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(stripes_count);
+        for (auto& stripe : stripes_)
+            locks.emplace_back(stripe.mtx);
+        return locks;
+    }
+
+    Stripe& stripe_of(AccountId id) const
+    {
+        assert(id < balances_.size());
+        return stripes_[stripe_index(id)];
+    }
+};
+
+#endif // BANK_HPP
@@ -1,9 +1,42 @@
+#include "bank.hpp"
+#include "journal.hpp"
+#include "load_generator.hpp"
+#include "stm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <deque>
+#include <filesystem>
+#include <functional>
 #include <iostream>
 #include <mutex>
+#include <numeric>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 inline namespace ver_1
 {
+    class BankAccount;
+
+    struct Transfer
+    {
+        BankAccount* from;
+        BankAccount* to;
+        double amount;
+    };
+
     class BankAccount
     {
         const int id_;
@@ -22,6 +55,8 @@ inline namespace ver_1
             std::cout << "Bank Account #" << id_ << "; Balance = " << balance() << std::endl;
         }
 
+        // Accounts are locked in the order of ids (then addresses) - the same order as transfer_batch(),
+        // so transfers and batches cannot deadlock each other whatever algorithm std::lock would use.
         void transfer(BankAccount& to, double amount)
         {
             // if (this->id_ <  to.id_)
@@ -41,29 +76,60 @@ inline namespace ver_1
             //     to.balance_ += amount;
             // }
 
+            if (&to == this)
+                return;
+
+            // built-in < of unrelated pointers is unspecified - std::less gives a strict total order
+            const bool is_this_first = id_ != to.id_ ? id_ < to.id_ : std::less<const BankAccount*>{}(this, &to);
+            BankAccount& first = is_this_first ? *this : to;
+            BankAccount& second = is_this_first ? to : *this;
+
 #if __cplusplus < 201703L
-            std::unique_lock<std::mutex> lk_from{mtx_, std::defer_lock};
-            std::unique_lock<std::mutex> lk_to{to.mtx_, std::defer_lock};
-            std::lock(lk_from, lk_to); // protection from deadlock - begin of critical section
-            balance_ -= amount;
-            to.balance_ += amount;
+            std::lock_guard<std::mutex> lk_first{first.mtx_}; // no class template argument deduction before C++17
+            std::lock_guard<std::mutex> lk_second{second.mtx_}; // begin of critical section
 #else
-            std::scoped_lock lk{mtx_, to.mtx_};
+            std::lock_guard lk_first{first.mtx_};
+            std::lock_guard lk_second{second.mtx_}; // begin of critical section
+#endif
             balance_ -= amount;
             to.balance_ += amount;
-#endif
         } // end of critical section
 
-        void withdraw(double amount)
+        // Applies all transfers as one critical section - e.g. a payroll run.
+        // Every touched account is locked once and always in the order of ids, so concurrent batches cannot deadlock
+        // and can be mixed with transfer(), which locks in the same order.
+        static void transfer_batch(std::span<const Transfer> transfers)
         {
-            std::unique_lock lk{mtx_, std::defer_lock};
-            do_lock();
-            balance_ -= amount;
+            std::vector<std::pair<int, BankAccount*>> accounts; // ids are copied - sorting does not touch the accounts
+            accounts.reserve(2 * transfers.size());
+            for (const auto& t : transfers)
+            {
+                accounts.emplace_back(t.from->id_, t.from);
+                accounts.emplace_back(t.to->id_, t.to);
+            }
+
+            std::sort(accounts.begin(), accounts.end(), [](const auto& a, const auto& b) {
+                return a.first != b.first ? a.first < b.first : std::less<const BankAccount*>{}(a.second, b.second);
+            });
+            accounts.erase(std::unique(accounts.begin(), accounts.end()), accounts.end());
+
+            for (auto [id, account] : accounts)
+                account->mtx_.lock();
+
+            for (const auto& t : transfers)
+            {
+                t.from->balance_ -= t.amount;
+                t.to->balance_ += t.amount;
+            }
+
+            for (auto it = accounts.rbegin(); it != accounts.rend(); ++it)
+                it->second->mtx_.unlock();
         }
 
-        void do_lock()
+        void withdraw(double amount)
         {
-            mtx_.lock();
+            std::lock_guard lk{mtx_};
+            balance_ -= amount;
         }
 
         void deposit(double amount)
@@ -153,16 +219,145 @@ namespace ver_2
     };
 } // namespace ver_2
 
-void make_withdraws(BankAccount& ba, int no_of_operations)
+namespace ver_3
+{
+    // balance in minor units (cents) - integer arithmetic does not drift and fits in one lock-free atomic
+    class BankAccount
+    {
+        const int id_;
+        std::atomic<int64_t> balance_;
+
+    public:
+        BankAccount(int id, int64_t balance)
+            : id_(id)
+            , balance_(balance)
+        {
+        }
+
+        void print() const
+        {
+            const int64_t current_balance = balance();
+            std::cout << "Bank Account #" << id_ << "; Balance = " << (current_balance < 0 ? "-" : "") << std::abs(current_balance / 100) << "."
+                      << std::setw(2) << std::setfill('0') << std::abs(current_balance % 100) << std::setfill(' ') << std::endl;
+        }
+
+        // money leaves this account before it arrives on the other one - the sum of balances is only consistent when no transfer is in progress
+        bool transfer(BankAccount& to, int64_t amount)
+        {
+            if (!withdraw(amount))
+                return false;
+
+            to.deposit(amount);
+            return true;
+        }
+
+        // fails instead of overdrawing the account
+        bool withdraw(int64_t amount)
+        {
+            int64_t current_balance = balance_.load(std::memory_order_relaxed);
+            do
+            {
+                if (current_balance < amount)
+                    return false;
+            } while (!balance_.compare_exchange_weak(current_balance, current_balance - amount, std::memory_order_relaxed));
+
+            return true;
+        }
+
+        // the balance is the only shared state of an account - atomicity is enough, no ordering with other memory is needed
+        void deposit(int64_t amount)
+        {
+            balance_.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        int id() const
+        {
+            return id_;
+        }
+
+        int64_t balance() const
+        {
+            return balance_.load(std::memory_order_relaxed);
+        }
+    };
+
+    static_assert(std::atomic<int64_t>::is_always_lock_free);
+} // namespace ver_3
+
+namespace ver_4
+{
+    // Operations are transactions - they compose into bigger atomic operations without any lock ordering:
+    //   Stm::atomically([&] { from.transfer(to, amount); from.withdraw(fee); fees.deposit(fee); });
+    class BankAccount
+    {
+        const int id_;
+        Stm::TVar<int64_t> balance_;
+
+    public:
+        BankAccount(int id, int64_t balance)
+            : id_(id)
+            , balance_(balance)
+        {
+        }
+
+        void print() const
+        {
+            std::cout << "Bank Account #" << id_ << "; Balance = " << balance() << std::endl;
+        }
+
+        bool transfer(BankAccount& to, int64_t amount)
+        {
+            return Stm::atomically([&] {
+                if (!withdraw(amount))
+                    return false;
+
+                to.deposit(amount);
+                return true;
+            });
+        }
+
+        // fails instead of overdrawing the account
+        bool withdraw(int64_t amount)
+        {
+            return Stm::atomically([&] {
+                const int64_t current_balance = balance_.get();
+                if (current_balance < amount)
+                    return false;
+
+                balance_.set(current_balance - amount);
+                return true;
+            });
+        }
+
+        void deposit(int64_t amount)
+        {
+            Stm::atomically([&] { balance_.set(balance_.get() + amount); });
+        }
+
+        int id() const
+        {
+            return id_;
+        }
+
+        int64_t balance() const
+        {
+            return Stm::atomically([&] { return balance_.get(); });
+        }
+    };
+} // namespace ver_4
+
+template <typename TBankAccount>
+void make_withdraws(TBankAccount& ba, int no_of_operations)
 {
     for (int i = 0; i < no_of_operations; ++i)
-        ba.withdraw(1.0);
+        ba.withdraw(1);
 }
 
-void make_deposits(BankAccount& ba, int no_of_operations)
+template <typename TBankAccount>
+void make_deposits(TBankAccount& ba, int no_of_operations)
 {
     for (int i = 0; i < no_of_operations; ++i)
-        ba.deposit(1.0);
+        ba.deposit(1);
 }
 
 void make_transfers(BankAccount& from, BankAccount& to, int no_of_operations)
@@ -171,8 +366,473 @@ void make_transfers(BankAccount& from, BankAccount& to, int no_of_operations)
         from.transfer(to, 1.0);
 }
 
-int main()
+// one thread withdraws while the other deposits the same amount - the balance must end where it started
+template <typename TBankAccount>
+void benchmark_withdraws_and_deposits(std::string_view name, int no_of_operations)
 {
+    TBankAccount ba(1, no_of_operations); // enough money for all withdraws, even when deposits lag behind
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::jthread thd_withdraws(&make_withdraws<TBankAccount>, std::ref(ba), no_of_operations);
+        std::jthread thd_deposits(&make_deposits<TBankAccount>, std::ref(ba), no_of_operations);
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << elapsed.count() << " ms" << std::setw(10) << 2 * no_of_operations / elapsed.count() / 1000.0 << " Mops/s"
+              << (ba.balance() == no_of_operations ? "" : " - balance is not conserved!") << std::defaultfloat << "\n";
+}
+
+std::vector<Transfer> random_transfers(std::deque<BankAccount>& accounts, size_t count, unsigned seed)
+{
+    std::mt19937 rnd_gen{seed};
+    std::uniform_int_distribution<size_t> rnd_account{0, accounts.size() - 1};
+
+    std::vector<Transfer> transfers;
+    transfers.reserve(count);
+    while (transfers.size() < count)
+    {
+        const size_t from = rnd_account(rnd_gen);
+        const size_t to = rnd_account(rnd_gen);
+        if (from != to)
+            transfers.push_back({&accounts[from], &accounts[to], 1.0});
+    }
+    return transfers;
+}
+
+// every thread applies its own random transfers between shared accounts - in batches or one by one
+void benchmark_transfer_batches(int threads_count, int accounts_count, int transfers_per_thread)
+{
+    std::cout << "\nTransfer batches (" << threads_count << " threads, " << accounts_count << " accounts, " << transfers_per_thread << " transfers per thread):\n"
+              << std::setw(12) << "batch size" << std::setw(20) << "batches [Mtr/s]" << std::setw(20) << "single [Mtr/s]" << "\n";
+
+    for (size_t batch_size : {10, 100, 1'000, 10'000})
+    {
+        std::deque<BankAccount> accounts; // BankAccount is not movable
+        for (int id = 0; id < accounts_count; ++id)
+            accounts.emplace_back(id, 1'000);
+
+        std::vector<std::vector<Transfer>> transfers;
+        for (int i = 0; i < threads_count; ++i)
+            transfers.push_back(random_transfers(accounts, batch_size, 665 + i));
+
+        const int rounds = std::max<int>(transfers_per_thread / static_cast<int>(batch_size), 1);
+
+        auto run = [&](auto apply_batch) {
+            const auto start = std::chrono::steady_clock::now();
+            {
+                std::vector<std::jthread> threads;
+                for (int i = 0; i < threads_count; ++i)
+                    threads.emplace_back([&, i] {
+                        for (int r = 0; r < rounds; ++r)
+                            apply_batch(transfers[i]);
+                    });
+            }
+            const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+            return static_cast<double>(threads_count) * rounds * batch_size / elapsed.count(); // transfers per microsecond = M/s
+        };
+
+        const double batches_rate = run([](std::span<const Transfer> batch) { BankAccount::transfer_batch(batch); });
+        const double single_rate = run([](std::span<const Transfer> batch) {
+            for (const auto& t : batch)
+                t.from->transfer(*t.to, t.amount);
+        });
+
+        const double total = std::accumulate(accounts.begin(), accounts.end(), 0.0, [](double sum, const BankAccount& ba) { return sum + ba.balance(); });
+
+        std::cout << std::setw(12) << batch_size << std::fixed << std::setprecision(2) << std::setw(20) << batches_rate << std::setw(20) << single_rate
+                  << (total == 1'000.0 * accounts_count ? "" : " - money is not conserved!") << std::defaultfloat << "\n";
+    }
+}
+
+// random transfers of threads_count threads among accounts_count accounts - ver_1::BankAccount objects vs Bank ledger
+void benchmark_bank(int threads_count, int accounts_count, int transfers_per_thread)
+{
+    std::cout << "\nLedger (" << threads_count << " threads, " << accounts_count << " accounts, " << transfers_per_thread << " transfers per thread):\n";
+
+    auto run_transfers = [&](auto transfer) {
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for (int i = 0; i < threads_count; ++i)
+                threads.emplace_back([&, i] {
+                    std::mt19937 rnd_gen(665 + i);
+                    std::uniform_int_distribution<int> rnd_account{0, accounts_count - 1};
+                    for (int n = 0; n < transfers_per_thread; ++n)
+                        transfer(rnd_account(rnd_gen), rnd_account(rnd_gen));
+                });
+        }
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(threads_count) * transfers_per_thread / elapsed.count();
+    };
+
+    auto print_row = [](std::string_view name, double bytes_per_account, double transfers_rate, double audit_ms, bool is_conserved) {
+        std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << bytes_per_account << " B/account" << std::setprecision(2) << std::setw(10) << transfers_rate << " Mtr/s"
+                  << std::setw(10) << audit_ms << " ms audit" << (is_conserved ? "" : " - money is not conserved!") << std::defaultfloat << "\n";
+    };
+
+    {
+        std::deque<BankAccount> accounts;
+        for (int id = 0; id < accounts_count; ++id)
+            accounts.emplace_back(id, 1'000);
+
+        const double rate = run_transfers([&](int from, int to) {
+            if (from != to)
+                accounts[from].transfer(accounts[to], 1.0);
+        });
+
+        const auto start = std::chrono::steady_clock::now();
+        const double total = std::accumulate(accounts.begin(), accounts.end(), 0.0, [](double sum, const BankAccount& ba) { return sum + ba.balance(); });
+        const std::chrono::duration<double, std::milli> audit_time = std::chrono::steady_clock::now() - start;
+
+        print_row("ver_1::BankAccount (deque)", sizeof(BankAccount), rate, audit_time.count(), total == 1'000.0 * accounts_count);
+    }
+
+    {
+        Bank bank(accounts_count, 1'000);
+
+        const double rate = run_transfers([&](int from, int to) { bank.transfer(from, to, 1); });
+
+        const auto start = std::chrono::steady_clock::now();
+        const int64_t total = bank.total_balance();
+        const std::chrono::duration<double, std::milli> audit_time = std::chrono::steady_clock::now() - start;
+
+        print_row("Bank (striped locks)", static_cast<double>(bank.memory_usage()) / accounts_count, rate, audit_time.count(), total == 1'000LL * accounts_count);
+    }
+}
+
+// random transfers between accounts_count accounts - locks of two accounts vs STM transactions,
+// the composed variant also charges a fee to a shared account and counts operations - one transaction, no extra locking code
+void benchmark_stm(int threads_count, int accounts_count, int transfers_per_thread)
+{
+    auto run_transfers = [&](auto transfer) {
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            for (int i = 0; i < threads_count; ++i)
+                threads.emplace_back([&, i] {
+                    std::mt19937 rnd_gen(665 + i);
+                    std::uniform_int_distribution<int> rnd_account{0, accounts_count - 1};
+                    for (int n = 0; n < transfers_per_thread; ++n)
+                    {
+                        const int from = rnd_account(rnd_gen);
+                        const int to = rnd_account(rnd_gen);
+                        if (from != to)
+                            transfer(from, to);
+                    }
+                });
+        }
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(threads_count) * transfers_per_thread / elapsed.count();
+    };
+
+    std::deque<ver_1::BankAccount> locked_accounts;
+    std::deque<ver_4::BankAccount> stm_accounts;
+    for (int id = 0; id < accounts_count; ++id)
+    {
+        locked_accounts.emplace_back(id, 1'000'000);
+        stm_accounts.emplace_back(id, 1'000'000);
+    }
+
+    ver_4::BankAccount fees(-1, 0);
+    Stm::TVar<int64_t> operations_count{0};
+
+    const double locked_rate = run_transfers([&](int from, int to) { locked_accounts[from].transfer(locked_accounts[to], 1.0); });
+    const double stm_rate = run_transfers([&](int from, int to) { stm_accounts[from].transfer(stm_accounts[to], 100); });
+    const double composed_rate = run_transfers([&](int from, int to) {
+        Stm::atomically([&] {
+            if (stm_accounts[from].transfer(stm_accounts[to], 100) && stm_accounts[from].withdraw(1))
+                fees.deposit(1);
+            operations_count.set(operations_count.get() + 1);
+        });
+    });
+
+    const int64_t total = Stm::atomically([&] {
+        return std::accumulate(stm_accounts.begin(), stm_accounts.end(), fees.balance(), [](int64_t sum, const ver_4::BankAccount& ba) { return sum + ba.balance(); });
+    });
+
+    std::cout << std::setw(10) << accounts_count << std::fixed << std::setprecision(2) << std::setw(18) << locked_rate << std::setw(18) << stm_rate
+              << std::setw(22) << composed_rate << (total == 1'000'000LL * accounts_count ? "" : " - money is not conserved!") << std::defaultfloat << "\n";
+}
+
+// BankAccount objects of one version as a ledger for the load generator - amounts in minor units
+template <typename TBankAccount>
+class AccountsLedger
+{
+    std::deque<TBankAccount> accounts_;
+
+public:
+    AccountsLedger(uint64_t accounts_count, int64_t initial_balance)
+    {
+        for (uint64_t id = 0; id < accounts_count; ++id)
+            accounts_.emplace_back(static_cast<int>(id), initial_balance);
+    }
+
+    int64_t balance(uint64_t id) const
+    {
+        return static_cast<int64_t>(accounts_[id].balance());
+    }
+
+    void deposit(uint64_t id, int64_t amount)
+    {
+        accounts_[id].deposit(amount);
+    }
+
+    bool withdraw(uint64_t id, int64_t amount)
+    {
+        if constexpr (std::is_void_v<decltype(accounts_[id].withdraw(amount))>) // ver_1 and ver_2 allow overdrafts
+        {
+            accounts_[id].withdraw(amount);
+            return true;
+        }
+        else
+            return accounts_[id].withdraw(amount);
+    }
+
+    bool transfer(uint64_t from, uint64_t to, int64_t amount)
+    {
+        if constexpr (requires { { accounts_[from].transfer(accounts_[to], amount) } -> std::same_as<bool>; })
+            return accounts_[from].transfer(accounts_[to], amount);
+        else if constexpr (requires { accounts_[from].transfer(accounts_[to], amount); })
+        {
+            accounts_[from].transfer(accounts_[to], amount);
+            return true;
+        }
+        else // ver_2 has no transfer - money is conserved, but the transfer is not atomic
+        {
+            withdraw(from, amount);
+            deposit(to, amount);
+            return true;
+        }
+    }
+
+    int64_t total_balance() const
+    {
+        int64_t total = 0;
+        for (uint64_t id = 0; id < accounts_.size(); ++id)
+            total += balance(id);
+        return total;
+    }
+};
+
+void print_load_usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " load [options]\n"
+              << "  --threads T             threads (default: hardware concurrency, at least 2)\n"
+              << "  --accounts N            number of accounts (default: 100000)\n"
+              << "  --ops N                 operations per thread (default: 1000000)\n"
+              << "  --mix R,W,T             percent of reads, writes (deposits/withdraws) and transfers (default: 50,30,20)\n"
+              << "  --theta Z               Zipfian skew of chosen accounts, 0 - uniform (default: 0.99)\n"
+              << "  --seed S                (default: 2024)\n";
+}
+
+LoadOptions parse_load_options(int argc, char* argv[])
+{
+    LoadOptions options;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+            throw std::invalid_argument("missing value of " + arg);
+        const std::string value = argv[++i];
+
+        if (arg == "--threads")
+            options.threads_count = static_cast<uint32_t>(std::stoul(value));
+        else if (arg == "--accounts")
+            options.accounts_count = std::stoull(value);
+        else if (arg == "--ops")
+            options.operations_per_thread = static_cast<uint64_t>(std::stod(value));
+        else if (arg == "--mix")
+        {
+            std::istringstream mix{value};
+            char comma1{}, comma2{};
+            if (!(mix >> options.reads_percent >> comma1 >> options.writes_percent >> comma2 >> options.transfers_percent) || comma1 != ',' || comma2 != ',')
+                throw std::invalid_argument("mix must be R,W,T");
+        }
+        else if (arg == "--theta")
+            options.zipf_theta = std::stod(value);
+        else if (arg == "--seed")
+            options.seed = std::stoull(value);
+        else
+            throw std::invalid_argument("unknown option " + arg);
+    }
+
+    if (options.threads_count == 0 || options.accounts_count < 2 || options.accounts_count > UINT32_MAX || options.operations_per_thread == 0)
+        throw std::invalid_argument("threads, ops must be positive, accounts in [2, 2^32)");
+    if (options.reads_percent + options.writes_percent + options.transfers_percent != 100)
+        throw std::invalid_argument("mix must sum to 100");
+    if (options.zipf_theta < 0.0 || options.zipf_theta >= 1.0)
+        throw std::invalid_argument("theta must be in [0, 1)");
+
+    return options;
+}
+
+// mixed, skewed load against every implementation - ops/s, latency percentiles and the money-conserved invariant
+int run_load_benchmark(int argc, char* argv[])
+{
+    LoadOptions options;
+    try
+    {
+        options = parse_load_options(argc, argv);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << "\n";
+        print_load_usage(argv[0]);
+        return 1;
+    }
+
+    const int64_t initial_balance = 1'000;
+    const ZipfianDistribution accounts_distribution{options.accounts_count, options.zipf_theta};
+
+    std::cout << "threads = " << options.threads_count << ", accounts = " << options.accounts_count << ", ops/thread = " << options.operations_per_thread
+              << ", mix (r/w/t) = " << options.reads_percent << "/" << options.writes_percent << "/" << options.transfers_percent
+              << ", zipf theta = " << options.zipf_theta << "\n\n"
+              << std::left << std::setw(32) << "implementation" << std::right << std::setw(14) << "Mops/s"
+              << std::setw(12) << "p50 ns" << std::setw(12) << "p99 ns" << std::setw(12) << "p99.9 ns" << "  invariant\n";
+
+    auto run = [&](std::string_view name, auto& ledger) {
+        const LoadResult result = run_load(ledger, options, accounts_distribution);
+        const bool is_conserved = ledger.total_balance() == initial_balance * static_cast<int64_t>(options.accounts_count) + result.net_deposits;
+
+        std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2) << std::setw(14) << result.ops_per_second / 1e6
+                  << std::setprecision(0) << std::setw(12) << result.p50_ns << std::setw(12) << result.p99_ns << std::setw(12) << result.p999_ns
+                  << (is_conserved ? "  money conserved" : "  MONEY NOT CONSERVED!") << std::defaultfloat << std::endl;
+        return is_conserved;
+    };
+
+    bool is_conserved = true;
+    {
+        AccountsLedger<ver_1::BankAccount> ledger(options.accounts_count, initial_balance);
+        is_conserved &= run("ver_1 - std::mutex", ledger);
+    }
+    {
+        AccountsLedger<ver_2::BankAccount> ledger(options.accounts_count, initial_balance);
+        is_conserved &= run("ver_2 - SynchronizedValue", ledger);
+    }
+    {
+        AccountsLedger<ver_3::BankAccount> ledger(options.accounts_count, initial_balance);
+        is_conserved &= run("ver_3 - std::atomic<int64_t>", ledger);
+    }
+    {
+        AccountsLedger<ver_4::BankAccount> ledger(options.accounts_count, initial_balance);
+        is_conserved &= run("ver_4 - STM", ledger);
+    }
+    {
+        Bank bank(options.accounts_count, initial_balance);
+        is_conserved &= run("Bank - striped locks", bank);
+    }
+
+    return is_conserved ? 0 : 2;
+}
+
+#if defined(__unix__)
+// durable transfers of many threads - every operation waits for its journal record on disk
+template <typename TLedger>
+double run_durable_transfers(TLedger& ledger, int threads_count, int operations_per_thread)
+{
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> threads;
+        for (int i = 0; i < threads_count; ++i)
+            threads.emplace_back([&, i] {
+                std::mt19937 rnd_gen(665 + i);
+                std::uniform_int_distribution<uint32_t> rnd_account{0, static_cast<uint32_t>(ledger.size() - 1)};
+                for (int n = 0; n < operations_per_thread; ++n)
+                    ledger.transfer(rnd_account(rnd_gen), rnd_account(rnd_gen), 1);
+            });
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return threads_count * operations_per_thread / elapsed.count();
+}
+
+// journal [threads=16] [operations per thread=1000] [recovery records=200000]
+int run_journal_benchmark(int argc, char* argv[])
+{
+    const int threads_count = argc > 2 ? std::stoi(argv[2]) : 16;
+    const int operations_per_thread = argc > 3 ? std::stoi(argv[3]) : 1'000;
+    const int recovery_records = argc > 4 ? std::stoi(argv[4]) : 200'000;
+    const size_t accounts_count = 100'000;
+    const int64_t initial_balance = 1'000;
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "bank_journal_benchmark";
+    std::filesystem::remove_all(directory);
+
+    std::cout << "Durable transfers (" << threads_count << " threads, " << operations_per_thread << " operations per thread, " << accounts_count << " accounts):\n";
+
+    auto print_row = [](std::string_view name, double ops_per_second, double records_per_sync) {
+        std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(0) << std::setw(12) << ops_per_second << " ops/s";
+        if (records_per_sync > 0)
+            std::cout << std::setprecision(1) << std::setw(10) << records_per_sync << " records/sync";
+        std::cout << std::defaultfloat << "\n";
+    };
+
+    {
+        Bank bank(accounts_count, initial_balance);
+        print_row("in memory (Bank)", run_durable_transfers(bank, threads_count, operations_per_thread), 0);
+    }
+
+    for (bool is_group_commit : {false, true})
+    {
+        std::filesystem::remove_all(directory);
+        JournaledBank bank(directory, accounts_count, initial_balance, {is_group_commit, 0});
+        const double rate = run_durable_transfers(bank, threads_count, operations_per_thread);
+        print_row(is_group_commit ? "journal - group commit" : "journal - fdatasync per operation", rate,
+            static_cast<double>(bank.journal().last_lsn()) / std::max<uint64_t>(bank.journal().syncs_count(), 1));
+    }
+
+    std::cout << "\nRecovery after " << recovery_records << " journaled operations:\n";
+
+    for (uint64_t snapshot_every : {uint64_t{0}, uint64_t{50'000}})
+    {
+        std::filesystem::remove_all(directory);
+
+        int64_t total_before;
+        {
+            JournaledBank bank(directory, accounts_count, initial_balance, {true, snapshot_every});
+            run_durable_transfers(bank, threads_count, recovery_records / threads_count);
+            total_before = bank.total_balance();
+
+            if (const std::exception_ptr failure = bank.snapshot_failure())
+            {
+                try
+                {
+                    std::rethrow_exception(failure);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cout << "snapshot failed: " << e.what() << "\n";
+                }
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        JournaledBank recovered(directory, accounts_count, initial_balance, {true, 0});
+        const std::chrono::duration<double, std::milli> recovery_time = std::chrono::steady_clock::now() - start;
+
+        std::cout << std::left << std::setw(32) << (snapshot_every > 0 ? "snapshot + journal tail" : "full journal replay") << std::right
+                  << std::fixed << std::setprecision(2) << std::setw(10) << recovery_time.count() << " ms" << std::setw(12) << recovered.replayed_records()
+                  << " records replayed" << (recovered.total_balance() == total_before ? "" : " - state is not recovered!") << std::defaultfloat << "\n";
+    }
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::string_view{argv[1]} == "load")
+        return run_load_benchmark(argc, argv);
+
+#if defined(__unix__)
+    if (argc > 1 && std::string_view{argv[1]} == "journal")
+        return run_journal_benchmark(argc, argv);
+#endif
+
     const int NO_OF_ITERS = 10'000'000;
 
     BankAccount ba1(1, 10'000);
@@ -182,8 +842,8 @@ int main()
     ba1.print();
     ba2.print();
 
-    std::thread thd1(&make_withdraws, std::ref(ba1), NO_OF_ITERS);
-    std::thread thd2(&make_deposits, std::ref(ba1), NO_OF_ITERS);
+    std::thread thd1(&make_withdraws<BankAccount>, std::ref(ba1), NO_OF_ITERS);
+    std::thread thd2(&make_deposits<BankAccount>, std::ref(ba1), NO_OF_ITERS);
     std::thread thd3(&make_transfers, std::ref(ba1), std::ref(ba2), NO_OF_ITERS / 10); // ba1 -> ba2 : { ba1.lock(); | ba2.lock(); do_transfer(); }
     std::thread thd4(&make_transfers, std::ref(ba2), std::ref(ba1), NO_OF_ITERS / 10); // ba2 -> ba1 : { ba2.lock(); | ba1.lock(); do_transfer();}
 
@@ -198,4 +858,18 @@ int main()
     std::cout << "After all threads are done: ";
     ba1.print();
     ba2.print();
+
+    std::cout << "\nWithdraws & deposits (" << NO_OF_ITERS << " operations per thread):\n";
+    benchmark_withdraws_and_deposits<ver_1::BankAccount>("ver_1 - std::mutex", NO_OF_ITERS);
+    benchmark_withdraws_and_deposits<ver_2::BankAccount>("ver_2 - SynchronizedValue", NO_OF_ITERS);
+    benchmark_withdraws_and_deposits<ver_3::BankAccount>("ver_3 - std::atomic<int64_t>", NO_OF_ITERS);
+
+    benchmark_transfer_batches(std::max(std::thread::hardware_concurrency(), 2u), 10'000, 1'000'000);
+
+    benchmark_bank(std::max(std::thread::hardware_concurrency(), 2u), 1'000'000, 1'000'000);
+
+    std::cout << "\nSTM vs locks (" << std::max(std::thread::hardware_concurrency(), 2u) << " threads, 1000000 transfers per thread) [Mtr/s]:\n"
+              << std::setw(10) << "accounts" << std::setw(18) << "ordered locks" << std::setw(18) << "STM" << std::setw(22) << "STM + fee + counter" << "\n";
+    for (int accounts_count : {4, 10'000}) // high and low contention
+        benchmark_stm(std::max(std::thread::hardware_concurrency(), 2u), accounts_count, 1'000'000);
 }
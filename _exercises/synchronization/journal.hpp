@@ -0,0 +1,678 @@
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include "bank.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Fixed-size record of a successful operation - replay applies its effect unconditionally.
+// The lsn is assigned under the locks of the accounts, so records of an account are in the order its operations were applied
+// and every prefix of the journal is a state the bank went through.
+struct JournalRecord
+{
+    enum class Type : uint32_t
+    {
+        deposit = 1,
+        withdraw = 2,
+        transfer = 3
+    };
+
+    uint64_t lsn; // log sequence number - record n of a segment starting at lsn b is stored at offset (n - b) * sizeof(JournalRecord)
+    Type type;
+    uint32_t account;
+    uint32_t other_account; // destination of a transfer
+    uint32_t checksum;      // of the other fields - detects a torn record at the end of the journal
+    int64_t amount;
+
+    uint32_t compute_checksum() const
+    {
+        JournalRecord copy = *this;
+        copy.checksum = 0;
+
+        unsigned char bytes[sizeof(JournalRecord)];
+        std::memcpy(bytes, &copy, sizeof(bytes));
+
+        uint32_t hash = 2'166'136'261u; // FNV-1a
+        for (unsigned char byte : bytes)
+            hash = (hash ^ byte) * 16'777'619u;
+        return hash;
+    }
+};
+
+static_assert(sizeof(JournalRecord) == 32);
+
+namespace JournalDetails
+{
+    inline void write_all(int fd, const void* data, size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            const ssize_t written = ::write(fd, bytes, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "journal write");
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    inline void sync(int fd)
+    {
+        if (::fdatasync(fd) != 0)
+            throw std::system_error(errno, std::generic_category(), "journal fdatasync");
+    }
+
+    // persists creation, renaming and removal of files in the directory
+    inline void sync_directory(const std::filesystem::path& directory)
+    {
+        const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd != -1)
+        {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+}
+
+// Append-only journal with group commit.
+//
+// append() only queues a record. wait_durable(lsn) returns when the record is on disk: the first waiter becomes the leader,
+// writes all queued records with one write() and one fdatasync(), while records of other threads queue up for the next batch.
+// Without group commit every append() writes and syncs its own record.
+//
+// Records are stored in segment files "journal.<lsn of the first record>" of a directory. start_segment() switches
+// the following batches to a new segment, so segments covered by a snapshot can be removed with remove_segments_before().
+class Journal
+{
+public:
+    // records from next_lsn on are appended to a new segment
+    Journal(const std::filesystem::path& directory, uint64_t next_lsn, bool is_group_commit = true)
+        : directory_{directory}
+        , next_lsn_{next_lsn}
+        , durable_lsn_{next_lsn - 1}
+        , is_group_commit_{is_group_commit}
+    {
+        fd_ = open_segment(directory_, next_lsn);
+    }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    ~Journal()
+    {
+        try
+        {
+            wait_durable(last_lsn());
+        }
+        catch (...)
+        {
+        }
+        ::close(fd_);
+    }
+
+    uint64_t append(JournalRecord record)
+    {
+        std::lock_guard lk{mtx_};
+        if (failure_)
+            std::rethrow_exception(failure_);
+
+        record.lsn = next_lsn_++;
+        record.checksum = record.compute_checksum();
+
+        if (!is_group_commit_)
+        {
+            try
+            {
+                write_batch(std::exchange(is_segment_requested_, false), &record, 1);
+            }
+            catch (...)
+            {
+                failure_ = std::current_exception();
+                throw;
+            }
+            durable_lsn_ = record.lsn;
+            ++syncs_count_;
+            return record.lsn;
+        }
+
+        pending_.push_back(record);
+        return record.lsn;
+    }
+
+    void wait_durable(uint64_t lsn)
+    {
+        std::unique_lock lk{mtx_};
+
+        while (durable_lsn_ < lsn)
+        {
+            if (failure_)
+                std::rethrow_exception(failure_); // records of the failed batch are lost - later records must not look durable
+
+            if (is_flushing_)
+            {
+                flushed_.wait(lk);
+                continue;
+            }
+
+            // leader of the next batch - the file is written without holding the mutex
+            is_flushing_ = true;
+            flushing_.swap(pending_);
+            const uint64_t batch_last_lsn = next_lsn_ - 1;
+            const bool is_new_segment = !flushing_.empty() && std::exchange(is_segment_requested_, false);
+            lk.unlock();
+
+            std::exception_ptr error;
+            try
+            {
+                write_batch(is_new_segment, flushing_.data(), flushing_.size());
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            lk.lock();
+            is_flushing_ = false;
+            flushing_.clear();
+            if (error)
+                failure_ = error;
+            else
+            {
+                durable_lsn_ = batch_last_lsn;
+                ++syncs_count_;
+            }
+            flushed_.notify_all();
+        }
+    }
+
+    // records appended from now on are written to a new segment
+    void start_segment()
+    {
+        std::lock_guard lk{mtx_};
+        is_segment_requested_ = true;
+    }
+
+    uint64_t last_lsn() const
+    {
+        std::lock_guard lk{mtx_};
+        return next_lsn_ - 1;
+    }
+
+    uint64_t syncs_count() const
+    {
+        std::lock_guard lk{mtx_};
+        return syncs_count_;
+    }
+
+    // removes segments whose records all precede lsn, e.g. are covered by a durable snapshot - the last segment is always kept
+    static void remove_segments_before(const std::filesystem::path& directory, uint64_t lsn)
+    {
+        const std::vector<Segment> all_segments = segments(directory);
+
+        bool is_removed = false;
+        for (size_t i = 0; i + 1 < all_segments.size() && all_segments[i + 1].first_lsn <= lsn; ++i)
+            is_removed |= std::filesystem::remove(all_segments[i].path);
+
+        if (is_removed)
+            JournalDetails::sync_directory(directory);
+    }
+
+    // Applies records from first_lsn to the first missing or torn one, which is cut off together with everything after it.
+    // Returns the next lsn.
+    template <typename F>
+    static uint64_t replay(const std::filesystem::path& directory, uint64_t first_lsn, F apply)
+    {
+        const std::vector<Segment> all_segments = segments(directory);
+
+        // the segment holding first_lsn - the last one starting at or before it
+        auto segment = std::find_if(all_segments.rbegin(), all_segments.rend(), [first_lsn](const Segment& s) { return s.first_lsn <= first_lsn; }).base();
+        if (segment == all_segments.begin())
+        {
+            if (!all_segments.empty())
+                throw std::runtime_error("journal records from " + std::to_string(first_lsn) + " to " + std::to_string(all_segments.front().first_lsn - 1)
+                    + " are missing");
+            return first_lsn;
+        }
+        --segment;
+
+        uint64_t lsn = first_lsn;
+        for (; segment != all_segments.end(); ++segment)
+        {
+            if (segment->first_lsn > lsn || !replay_segment(*segment, lsn, apply))
+                break; // a gap between segments or a torn record
+        }
+
+        // records after the first missing one do not belong to any state the bank went through
+        bool is_removed = false;
+        if (segment != all_segments.end())
+        {
+            for (auto later = std::next(segment); later != all_segments.end(); ++later)
+                is_removed |= std::filesystem::remove(later->path);
+            if (segment->first_lsn > lsn)
+                is_removed |= std::filesystem::remove(segment->path);
+        }
+        if (is_removed)
+            JournalDetails::sync_directory(directory);
+
+        return lsn;
+    }
+
+private:
+    struct Segment
+    {
+        uint64_t first_lsn;
+        std::filesystem::path path;
+    };
+
+    std::filesystem::path directory_;
+    int fd_;
+    mutable std::mutex mtx_;
+    std::condition_variable flushed_;
+    std::vector<JournalRecord> pending_;
+    std::vector<JournalRecord> flushing_; // buffers are swapped - no allocation in steady state
+    uint64_t next_lsn_;
+    uint64_t durable_lsn_;
+    uint64_t syncs_count_ = 0;
+    bool is_flushing_ = false;
+    bool is_segment_requested_ = false;
+    std::exception_ptr failure_; // of a write - the journal stops accepting records
+    const bool is_group_commit_;
+
+    static std::filesystem::path segment_path(const std::filesystem::path& directory, uint64_t first_lsn)
+    {
+        return directory / ("journal." + std::to_string(first_lsn));
+    }
+
+    // segments of the directory ordered by their first lsn
+    static std::vector<Segment> segments(const std::filesystem::path& directory)
+    {
+        std::vector<Segment> result;
+
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
+        {
+            const std::string name = entry.path().filename().string();
+            if (!name.starts_with("journal.") || name.size() == 8 || name.find_first_not_of("0123456789", 8) != std::string::npos)
+                continue;
+
+            result.push_back({std::stoull(name.substr(8)), entry.path()});
+        }
+
+        std::sort(result.begin(), result.end(), [](const Segment& a, const Segment& b) { return a.first_lsn < b.first_lsn; });
+        return result;
+    }
+
+    static int open_segment(const std::filesystem::path& directory, uint64_t first_lsn)
+    {
+        const std::filesystem::path path = segment_path(directory, first_lsn);
+
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd == -1)
+            throw std::system_error(errno, std::generic_category(), "cannot open journal " + path.string());
+
+        JournalDetails::sync_directory(directory); // the segment must not disappear with its records after a crash
+        return fd;
+    }
+
+    // called by the leader or under mtx_ without group commit - the only writers of fd_
+    void write_batch(bool is_new_segment, const JournalRecord* records, size_t count)
+    {
+        if (is_new_segment) // records written to the previous segment have already been synced
+        {
+            const int fd = open_segment(directory_, records[0].lsn);
+            ::close(fd_);
+            fd_ = fd;
+        }
+
+        JournalDetails::write_all(fd_, records, count * sizeof(JournalRecord));
+        JournalDetails::sync(fd_);
+    }
+
+    // applies valid records of the segment from lsn on - returns false when a torn record or a partial one has been cut off
+    template <typename F>
+    static bool replay_segment(const Segment& segment, uint64_t& lsn, F& apply)
+    {
+        const int fd = ::open(segment.path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd == -1)
+            throw std::system_error(errno, std::generic_category(), "cannot open journal " + segment.path.string());
+
+        std::vector<JournalRecord> records(64 * 1024);
+        bool is_valid = true;
+
+        for (off_t offset = static_cast<off_t>((lsn - segment.first_lsn) * sizeof(JournalRecord)); is_valid;)
+        {
+            const ssize_t bytes_read = ::pread(fd, records.data(), records.size() * sizeof(JournalRecord), offset);
+            if (bytes_read <= 0)
+                break;
+
+            const size_t records_count = static_cast<size_t>(bytes_read) / sizeof(JournalRecord);
+            for (size_t i = 0; i < records_count; ++i)
+            {
+                if (records[i].lsn != lsn || records[i].checksum != records[i].compute_checksum())
+                {
+                    is_valid = false;
+                    break;
+                }
+
+                try
+                {
+                    apply(records[i]);
+                }
+                catch (...)
+                {
+                    ::close(fd);
+                    throw;
+                }
+                ++lsn;
+            }
+
+            if (records_count * sizeof(JournalRecord) != static_cast<size_t>(bytes_read))
+            {
+                is_valid = false; // partial record at the end
+                break;
+            }
+            offset += bytes_read;
+        }
+
+        // a file shorter than the first replayed record (e.g. covered by the snapshot) must not be extended with zeros
+        const auto valid_size = static_cast<off_t>((lsn - segment.first_lsn) * sizeof(JournalRecord));
+        struct stat status{};
+        int result = ::fstat(fd, &status);
+        if (result == 0 && status.st_size > valid_size)
+        {
+            is_valid = false;
+            result = ::ftruncate(fd, valid_size);
+        }
+        ::close(fd);
+        if (result != 0)
+            throw std::system_error(errno, std::generic_category(), "cannot truncate journal " + segment.path.string());
+
+        return is_valid;
+    }
+};
+
+struct JournaledBankOptions
+{
+    bool is_group_commit = true;
+    uint64_t snapshot_every_records = 1'000'000; // 0 - no automatic snapshots
+};
+
+// Bank with durable operations - an operation returns after its record is in the journal on disk.
+//
+// Startup restores the latest snapshot and replays only the journal records written after it.
+// Snapshots are taken by a background thread: operations are paused only to copy the balances.
+// Every snapshot starts a new journal segment and removes the segments it covers, so the journal on disk stays
+// within about two snapshot periods.
+//
+// Balances read by other threads may include operations whose records are not durable yet.
+// When the journal fails, an operation that has already changed the balances throws from waiting for its record:
+// the change stays in memory but may be lost after restart. The failure is sticky - every later operation throws
+// without changing anything, so the bank has to be recovered from disk.
+class JournaledBank
+{
+public:
+    JournaledBank(const std::filesystem::path& directory, size_t accounts_count, int64_t initial_balance, JournaledBankOptions options = {})
+        : directory_{directory}
+        , options_{options}
+    {
+        std::filesystem::create_directories(directory_);
+
+        std::vector<int64_t> balances;
+        uint64_t snapshot_lsn = 0;
+        if (!read_snapshot(accounts_count, balances, snapshot_lsn))
+            balances.assign(accounts_count, initial_balance);
+
+        const uint64_t next_lsn = Journal::replay(directory_, snapshot_lsn + 1, [&balances](const JournalRecord& record) {
+            if (record.account >= balances.size() || (record.type == JournalRecord::Type::transfer && record.other_account >= balances.size()))
+                throw std::runtime_error("journal record " + std::to_string(record.lsn) + " refers to an account out of range");
+
+            switch (record.type)
+            {
+            case JournalRecord::Type::deposit:
+                balances[record.account] += record.amount;
+                break;
+            case JournalRecord::Type::withdraw:
+                balances[record.account] -= record.amount;
+                break;
+            case JournalRecord::Type::transfer:
+                balances[record.account] -= record.amount;
+                balances[record.other_account] += record.amount;
+                break;
+            }
+        });
+
+        replayed_records_ = next_lsn - 1 - snapshot_lsn;
+        snapshot_lsn_ = snapshot_lsn;
+        bank_ = std::make_unique<Bank>(std::move(balances));
+        journal_ = std::make_unique<Journal>(directory_, next_lsn, options_.is_group_commit);
+
+        if (options_.snapshot_every_records > 0)
+            snapshot_thread_ = std::jthread([this](std::stop_token stop_token) { take_snapshots(stop_token); });
+    }
+
+    ~JournaledBank()
+    {
+        if (snapshot_thread_.joinable())
+        {
+            snapshot_thread_.request_stop();
+            snapshot_thread_.join();
+        }
+    }
+
+    size_t size() const
+    {
+        return bank_->size();
+    }
+
+    int64_t balance(Bank::AccountId id) const
+    {
+        return bank_->balance(id);
+    }
+
+    void deposit(Bank::AccountId id, int64_t amount)
+    {
+        apply_durably([&](auto append) { bank_->deposit(id, amount, append); return true; }, {0, JournalRecord::Type::deposit, id, 0, 0, amount});
+    }
+
+    bool withdraw(Bank::AccountId id, int64_t amount)
+    {
+        return apply_durably([&](auto append) { return bank_->withdraw(id, amount, append); }, {0, JournalRecord::Type::withdraw, id, 0, 0, amount});
+    }
+
+    bool transfer(Bank::AccountId from, Bank::AccountId to, int64_t amount)
+    {
+        return apply_durably(
+            [&](auto append) { return bank_->transfer(from, to, amount, append); }, {0, JournalRecord::Type::transfer, from, to, 0, amount});
+    }
+
+    int64_t total_balance() const
+    {
+        return bank_->total_balance();
+    }
+
+    // writes balances with the lsn of the last included record - replay after restart starts behind it
+    void snapshot()
+    {
+        std::lock_guard snapshot_lk{snapshot_write_mutex_}; // the background thread and callers write one file
+
+        uint64_t lsn = 0;
+        // records are appended under the locks of accounts - with all of them held, every record up to lsn is in the balances
+        const std::vector<int64_t> balances = bank_->balances([&] { lsn = journal_->last_lsn(); });
+
+        journal_->wait_durable(lsn); // the snapshot must not be ahead of the journal
+        write_snapshot(balances, lsn);
+        snapshot_lsn_ = lsn;
+
+        // the journal would grow without bound - later records go to a new segment and the covered ones are removed
+        journal_->start_segment();
+        Journal::remove_segments_before(directory_, lsn + 1);
+    }
+
+    uint64_t replayed_records() const
+    {
+        return replayed_records_;
+    }
+
+    // the last error of the background snapshots, empty after a snapshot succeeds
+    std::exception_ptr snapshot_failure() const
+    {
+        std::lock_guard lk{snapshot_failure_mutex_};
+        return snapshot_failure_;
+    }
+
+    const Journal& journal() const
+    {
+        return *journal_;
+    }
+
+private:
+    std::filesystem::path directory_;
+    JournaledBankOptions options_;
+    std::unique_ptr<Bank> bank_;
+    std::unique_ptr<Journal> journal_;
+    std::mutex snapshot_write_mutex_;
+    mutable std::mutex snapshot_failure_mutex_;
+    std::exception_ptr snapshot_failure_;
+    std::atomic<uint64_t> snapshot_lsn_{0};
+    uint64_t replayed_records_ = 0;
+    std::jthread snapshot_thread_;
+
+    struct SnapshotHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t accounts_count;
+        uint64_t lsn;
+    };
+
+    static constexpr char snapshot_magic[4] = {'B', 'S', 'N', 'P'};
+
+    std::filesystem::path snapshot_path() const
+    {
+        return directory_ / "snapshot";
+    }
+
+    template <typename F>
+    bool apply_durably(F operation, JournalRecord record)
+    {
+        uint64_t lsn = 0;
+        if (!operation([&] { lsn = journal_->append(record); }))
+            return false; // failed operations change nothing - not journaled
+
+        journal_->wait_durable(lsn);
+        return true;
+    }
+
+    void take_snapshots(std::stop_token stop_token)
+    {
+        std::mutex mtx;
+        std::condition_variable_any stopped;
+
+        while (!stop_token.stop_requested())
+        {
+            {
+                std::unique_lock lk{mtx};
+                stopped.wait_for(lk, stop_token, std::chrono::milliseconds{100}, [] { return false; });
+            }
+
+            if (stop_token.stop_requested() || journal_->last_lsn() - snapshot_lsn_ < options_.snapshot_every_records)
+                continue;
+
+            // e.g. a full disk - kept for snapshot_failure() and retried in the next period, the journal stays the source of truth
+            std::exception_ptr failure;
+            try
+            {
+                snapshot();
+            }
+            catch (...)
+            {
+                failure = std::current_exception();
+            }
+
+            std::lock_guard lk{snapshot_failure_mutex_};
+            snapshot_failure_ = failure;
+        }
+    }
+
+    void write_snapshot(const std::vector<int64_t>& balances, uint64_t lsn) const
+    {
+        const std::filesystem::path temporary_path = snapshot_path().string() + ".tmp";
+
+        const int fd = ::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1)
+            throw std::system_error(errno, std::generic_category(), "cannot create snapshot " + temporary_path.string());
+
+        SnapshotHeader header{{}, 1, balances.size(), lsn};
+        std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+
+        try
+        {
+            JournalDetails::write_all(fd, &header, sizeof(header));
+            JournalDetails::write_all(fd, balances.data(), balances.size() * sizeof(int64_t));
+            JournalDetails::sync(fd);
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+
+        std::filesystem::rename(temporary_path, snapshot_path()); // atomic replacement of the previous snapshot
+        JournalDetails::sync_directory(directory_);
+    }
+
+    bool read_snapshot(size_t accounts_count, std::vector<int64_t>& balances, uint64_t& lsn) const
+    {
+        const int fd = ::open(snapshot_path().c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            return false;
+
+        SnapshotHeader header{};
+        bool is_valid = ::read(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header))
+            && std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) == 0 && header.version == 1
+            && header.accounts_count == accounts_count;
+
+        if (is_valid)
+        {
+            balances.resize(header.accounts_count);
+            const size_t size = balances.size() * sizeof(int64_t);
+            is_valid = ::read(fd, balances.data(), size) == static_cast<ssize_t>(size);
+        }
+
+        if (is_valid)
+            lsn = header.lsn; // replay of an invalid snapshot starts from the first record
+
+        ::close(fd);
+        return is_valid;
+    }
+};
+#endif
+
+#endif // JOURNAL_HPP
@@ -0,0 +1,172 @@
+#ifndef LOAD_GENERATOR_HPP
+#define LOAD_GENERATOR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <latch>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Zipfian distribution over [0, n) (Gray et al., "Quickly Generating Billion-Record Synthetic Databases", the generator of YCSB).
+// Construction is O(n), every sample is O(1). theta = 0 - uniform.
+//
+// Ranks are mapped to ids by a fixed permutation, like ScrambledZipfian of YCSB - the hottest accounts are spread over
+// the id space instead of being neighbours, which would share a cache line and a stripe of Bank.
+class ZipfianDistribution
+{
+public:
+    ZipfianDistribution(uint64_t n, double theta)
+        : n_{n}
+        , theta_{theta}
+    {
+        if (theta_ <= 0.0)
+            return;
+
+        double zeta_n = 0.0;
+        for (uint64_t i = 1; i <= n_; ++i)
+            zeta_n += 1.0 / std::pow(static_cast<double>(i), theta_);
+
+        const double zeta_2 = 1.0 + 1.0 / std::pow(2.0, theta_);
+        zeta_n_ = zeta_n;
+        alpha_ = 1.0 / (1.0 - theta_);
+        eta_ = (1.0 - std::pow(2.0 / static_cast<double>(n_), 1.0 - theta_)) / (1.0 - zeta_2 / zeta_n_);
+        half_pow_theta_ = 1.0 + std::pow(0.5, theta_);
+
+        ids_.resize(n_);
+        std::iota(ids_.begin(), ids_.end(), uint64_t{0});
+        std::shuffle(ids_.begin(), ids_.end(), std::mt19937_64{0x5EED}); // the same permutation in every run
+    }
+
+    template <typename TUrbg>
+    uint64_t operator()(TUrbg& rnd_gen) const
+    {
+        const double u = std::uniform_real_distribution<double>{0.0, 1.0}(rnd_gen);
+
+        if (theta_ <= 0.0)
+            return std::min(static_cast<uint64_t>(u * static_cast<double>(n_)), n_ - 1);
+
+        return ids_[rank(u)];
+    }
+
+private:
+    uint64_t n_;
+    double theta_;
+    double zeta_n_ = 0.0;
+    double alpha_ = 0.0;
+    double eta_ = 0.0;
+    double half_pow_theta_ = 0.0;
+    std::vector<uint64_t> ids_; // id of every rank
+
+    // rank 0 is the hottest
+    uint64_t rank(double u) const
+    {
+        const double uz = u * zeta_n_;
+        if (uz < 1.0)
+            return 0;
+        if (uz < half_pow_theta_)
+            return std::min<uint64_t>(1, n_ - 1);
+
+        return std::min(static_cast<uint64_t>(static_cast<double>(n_) * std::pow(eta_ * u - eta_ + 1.0, alpha_)), n_ - 1);
+    }
+};
+
+struct LoadOptions
+{
+    uint32_t threads_count = std::max(std::thread::hardware_concurrency(), 2u);
+    uint64_t accounts_count = 100'000;
+    uint64_t operations_per_thread = 1'000'000;
+    // mix of operations in percent - writes are deposits and withdraws in equal parts
+    uint32_t reads_percent = 50;
+    uint32_t writes_percent = 30;
+    uint32_t transfers_percent = 20;
+    double zipf_theta = 0.99; // skew of accounts chosen by operations, 0 - uniform
+    uint64_t seed = 2024;
+};
+
+struct LoadResult
+{
+    double ops_per_second;
+    double p50_ns;
+    double p99_ns;
+    double p999_ns;
+    int64_t net_deposits; // deposits minus successful withdraws - the expected change of the total balance
+};
+
+// Runs the mixed load against a ledger with operations:
+//   int64_t balance(id), void deposit(id, amount), bool withdraw(id, amount), bool transfer(from, to, amount)
+// Latency of every operation is recorded; threads start together after preparing their buffers.
+template <typename TLedger>
+LoadResult run_load(TLedger& ledger, const LoadOptions& options, const ZipfianDistribution& accounts_distribution)
+{
+    const uint64_t operations_count = options.threads_count * options.operations_per_thread;
+    std::vector<uint32_t> latencies_ns(operations_count);
+    std::vector<int64_t> net_deposits(options.threads_count);
+
+    std::latch start_line{options.threads_count + 1};
+    std::chrono::steady_clock::time_point start;
+    {
+        std::vector<std::jthread> threads;
+        for (uint32_t i = 0; i < options.threads_count; ++i)
+        {
+            threads.emplace_back([&, i] {
+                std::mt19937_64 rnd_gen{options.seed + i};
+                std::uniform_int_distribution<uint32_t> rnd_percent{0, 99};
+                uint32_t* latencies = latencies_ns.data() + i * options.operations_per_thread;
+                int64_t net = 0;
+
+                start_line.arrive_and_wait();
+
+                for (uint64_t n = 0; n < options.operations_per_thread; ++n)
+                {
+                    const uint32_t operation = rnd_percent(rnd_gen);
+                    const uint64_t account = accounts_distribution(rnd_gen);
+                    const uint64_t other_account = operation >= options.reads_percent + options.writes_percent ? accounts_distribution(rnd_gen) : 0;
+
+                    const auto operation_start = std::chrono::steady_clock::now();
+
+                    if (operation < options.reads_percent)
+                        ledger.balance(account);
+                    else if (operation < options.reads_percent + options.writes_percent)
+                    {
+                        if (n % 2 == 0)
+                        {
+                            ledger.deposit(account, 1);
+                            ++net;
+                        }
+                        else if (ledger.withdraw(account, 1))
+                            --net;
+                    }
+                    else if (account != other_account)
+                        ledger.transfer(account, other_account, 1);
+
+                    latencies[n] = static_cast<uint32_t>(std::min<int64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - operation_start).count(), UINT32_MAX));
+                }
+
+                net_deposits[i] = net;
+            });
+        }
+
+        start = std::chrono::steady_clock::now();
+        start_line.arrive_and_wait();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    auto percentile = [&](double p) {
+        auto nth = latencies_ns.begin() + static_cast<ptrdiff_t>(p * static_cast<double>(latencies_ns.size() - 1));
+        std::nth_element(latencies_ns.begin(), nth, latencies_ns.end());
+        return static_cast<double>(*nth);
+    };
+
+    int64_t net = 0;
+    for (int64_t thread_net : net_deposits)
+        net += thread_net;
+
+    return {static_cast<double>(operations_count) / elapsed.count(), percentile(0.5), percentile(0.99), percentile(0.999), net};
+}
+
+#endif // LOAD_GENERATOR_HPP
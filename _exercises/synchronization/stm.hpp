@@ -0,0 +1,266 @@
+#ifndef STM_HPP
+#define STM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Word-based software transactional memory in the style of TL2 (Dice, Shalev, Shavit):
+// every variable has a versioned lock, a global clock orders commits.
+//
+//   Stm::TVar<int64_t> a{100}, b{0};
+//   Stm::atomically([&] { a.set(a.get() - 10); b.set(b.get() + 10); });
+//
+// Reads are validated against the clock value at the start of a transaction, so a transaction never sees an inconsistent state;
+// writes are buffered and published at commit, when locks of the written variables are held. Conflicts restart the transaction.
+namespace Stm
+{
+    class Transaction;
+
+    namespace Details
+    {
+        inline std::atomic<uint64_t> global_clock{0};
+
+        inline thread_local Transaction* current_transaction = nullptr;
+
+        struct Conflict
+        {
+        };
+
+        // lock word: version << 1 | locked
+        constexpr uint64_t locked_bit = 1;
+
+        class TVarBase
+        {
+        protected:
+            explicit TVarBase(uint64_t bits)
+                : bits_{bits}
+            {
+            }
+
+            TVarBase(const TVarBase&) = delete;
+            TVarBase& operator=(const TVarBase&) = delete;
+
+            std::atomic<uint64_t> lock_{0};
+            std::atomic<uint64_t> bits_;
+
+            friend class Stm::Transaction;
+        };
+    }
+
+    class Transaction
+    {
+    public:
+        // a thread reuses one transaction object - buffers of read and write sets are not allocated again
+        void begin()
+        {
+            read_version_ = Details::global_clock.load(std::memory_order_acquire);
+            read_set_.clear();
+            write_set_.clear();
+        }
+
+        uint64_t read(const Details::TVarBase& var)
+        {
+            for (const auto& [written_var, bits] : write_set_) // transactions are small - a linear search beats hashing
+                if (written_var == &var)
+                    return bits;
+
+            const uint64_t lock_before = var.lock_.load(std::memory_order_acquire);
+            const uint64_t bits = var.bits_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64_t lock_after = var.lock_.load(std::memory_order_relaxed);
+
+            if ((lock_before & Details::locked_bit) || lock_before != lock_after || (lock_before >> 1) > read_version_)
+                throw Details::Conflict{};
+
+            read_set_.push_back(&var);
+            return bits;
+        }
+
+        void write(Details::TVarBase& var, uint64_t bits)
+        {
+            for (auto& [written_var, written_bits] : write_set_)
+                if (written_var == &var)
+                {
+                    written_bits = bits;
+                    return;
+                }
+
+            write_set_.emplace_back(&var, bits);
+        }
+
+        void commit()
+        {
+            if (write_set_.empty())
+                return; // every read was consistent with read_version_
+
+            // no waiting for locks - a failed try-lock restarts the transaction, so there are no deadlocks
+            size_t locked_count = 0;
+            for (; locked_count < write_set_.size(); ++locked_count)
+            {
+                Details::TVarBase& var = *write_set_[locked_count].first;
+                uint64_t lock = var.lock_.load(std::memory_order_relaxed);
+                if ((lock & Details::locked_bit) || !var.lock_.compare_exchange_strong(lock, lock | Details::locked_bit, std::memory_order_acquire))
+                {
+                    unlock(locked_count);
+                    throw Details::Conflict{};
+                }
+            }
+
+            const uint64_t write_version = Details::global_clock.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+            // nobody committed since the start - the read set cannot be stale
+            if (write_version != read_version_ + 1)
+            {
+                for (const Details::TVarBase* var : read_set_)
+                {
+                    const uint64_t lock = var->lock_.load(std::memory_order_acquire);
+                    if ((lock >> 1) > read_version_ || ((lock & Details::locked_bit) && !is_written(var)))
+                    {
+                        unlock(locked_count);
+                        throw Details::Conflict{};
+                    }
+                }
+            }
+
+            std::atomic_thread_fence(std::memory_order_release); // a reader seeing a new value also sees the lock
+            for (auto& [var, bits] : write_set_)
+            {
+                var->bits_.store(bits, std::memory_order_relaxed);
+                var->lock_.store(write_version << 1, std::memory_order_release); // new version, unlocked
+            }
+        }
+
+    private:
+        uint64_t read_version_ = 0;
+        std::vector<const Details::TVarBase*> read_set_;
+        std::vector<std::pair<Details::TVarBase*, uint64_t>> write_set_;
+
+        bool is_written(const Details::TVarBase* var) const
+        {
+            return std::any_of(write_set_.begin(), write_set_.end(), [var](const auto& write) { return write.first == var; });
+        }
+
+        void unlock(size_t locked_count)
+        {
+            for (size_t i = 0; i < locked_count; ++i)
+                write_set_[i].first->lock_.fetch_and(~Details::locked_bit, std::memory_order_release);
+        }
+    };
+
+    namespace Details
+    {
+        inline Transaction& thread_transaction()
+        {
+            thread_local Transaction transaction;
+            return transaction;
+        }
+    }
+
+    // Transactional variable - trivially copyable value up to 8 bytes.
+    // get() and set() may be called only inside atomically().
+    template <typename T>
+    class TVar : public Details::TVarBase
+    {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(uint64_t));
+
+    public:
+        explicit TVar(T value = T{})
+            : TVarBase{to_bits(value)}
+        {
+        }
+
+        T get() const
+        {
+            assert(Details::current_transaction && "TVar::get() outside of atomically()");
+            return from_bits(Details::current_transaction->read(*this));
+        }
+
+        void set(T value)
+        {
+            assert(Details::current_transaction && "TVar::set() outside of atomically()");
+            Details::current_transaction->write(*this, to_bits(value));
+        }
+
+    private:
+        static uint64_t to_bits(T value)
+        {
+            if constexpr (sizeof(T) == sizeof(uint64_t))
+                return std::bit_cast<uint64_t>(value);
+            else
+            {
+                uint64_t bits = 0;
+                std::memcpy(&bits, &value, sizeof(T));
+                return bits;
+            }
+        }
+
+        static T from_bits(uint64_t bits)
+        {
+            if constexpr (sizeof(T) == sizeof(uint64_t))
+                return std::bit_cast<T>(bits);
+            else
+            {
+                T value;
+                std::memcpy(&value, &bits, sizeof(T));
+                return value;
+            }
+        }
+    };
+
+    // Runs f() as a transaction until it commits and returns its result.
+    // f may run several times, so it must not have side effects other than on TVars.
+    // Nested calls join the enclosing transaction. An exception thrown by f discards the transaction and is rethrown.
+    template <typename F>
+    auto atomically(F&& f) -> std::invoke_result_t<F&>
+    {
+        if (Details::current_transaction)
+            return f();
+
+        Transaction& tx = Details::thread_transaction();
+
+        for (int attempt = 0;; ++attempt)
+        {
+            tx.begin();
+            Details::current_transaction = &tx;
+
+            try
+            {
+                if constexpr (std::is_void_v<std::invoke_result_t<F&>>)
+                {
+                    f();
+                    tx.commit();
+                    Details::current_transaction = nullptr;
+                    return;
+                }
+                else
+                {
+                    auto result = f();
+                    tx.commit();
+                    Details::current_transaction = nullptr;
+                    return result;
+                }
+            }
+            catch (const Details::Conflict&)
+            {
+                Details::current_transaction = nullptr;
+                if (attempt > 8) // back off under heavy contention
+                    std::this_thread::yield();
+            }
+            catch (...)
+            {
+                Details::current_transaction = nullptr;
+                throw;
+            }
+        }
+    }
+}
+
+#endif // STM_HPP
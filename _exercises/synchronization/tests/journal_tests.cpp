@@ -0,0 +1,286 @@
+#include "journal.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#if defined(__unix__)
+namespace
+{
+    namespace fs = std::filesystem;
+
+    struct TemporaryDirectory
+    {
+        fs::path path;
+
+        explicit TemporaryDirectory(const string& name)
+            : path{fs::temp_directory_path() / (name + "_" + to_string(::getpid()))}
+        {
+            fs::remove_all(path);
+            fs::create_directories(path);
+        }
+
+        ~TemporaryDirectory()
+        {
+            error_code ec;
+            fs::remove_all(path, ec);
+        }
+    };
+
+    JournalRecord deposit_record(uint32_t account, int64_t amount)
+    {
+        return {0, JournalRecord::Type::deposit, account, 0, 0, amount};
+    }
+
+    // appends deposits with the amount equal to their lsn - every one written and synced on its own
+    void append_records(const fs::path& directory, uint64_t first_lsn, int count)
+    {
+        Journal journal{directory, first_lsn, false};
+        for (int i = 0; i < count; ++i)
+            journal.append(deposit_record(0, static_cast<int64_t>(first_lsn) + i));
+    }
+
+    vector<uint64_t> replayed_lsns(const fs::path& directory, uint64_t first_lsn, uint64_t& next_lsn)
+    {
+        vector<uint64_t> lsns;
+        next_lsn = Journal::replay(directory, first_lsn, [&lsns](const JournalRecord& record) {
+            REQUIRE(record.amount == static_cast<int64_t>(record.lsn));
+            lsns.push_back(record.lsn);
+        });
+        return lsns;
+    }
+
+    vector<uint64_t> lsn_range(uint64_t first, uint64_t last)
+    {
+        vector<uint64_t> lsns;
+        for (uint64_t lsn = first; lsn <= last; ++lsn)
+            lsns.push_back(lsn);
+        return lsns;
+    }
+
+    set<string> file_names(const fs::path& directory)
+    {
+        set<string> names;
+        for (const auto& entry : fs::directory_iterator{directory})
+            names.insert(entry.path().filename().string());
+        return names;
+    }
+
+    void overwrite(const fs::path& path, uint64_t offset, const string& bytes)
+    {
+        fstream file{path, ios::in | ios::out | ios::binary};
+        file.seekp(static_cast<streamoff>(offset));
+        file.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+    }
+
+    void append_bytes(const fs::path& path, const string& bytes)
+    {
+        ofstream{path, ios::binary | ios::app} << bytes;
+    }
+}
+
+TEST_CASE("Journal - recovery")
+{
+    TemporaryDirectory dir{"journal_tests"};
+    uint64_t next_lsn = 0;
+
+    SECTION("replays all records of an intact journal")
+    {
+        append_records(dir.path, 1, 5);
+
+        REQUIRE(replayed_lsns(dir.path, 1, next_lsn) == lsn_range(1, 5));
+        REQUIRE(next_lsn == 6);
+        REQUIRE(fs::file_size(dir.path / "journal.1") == 5 * sizeof(JournalRecord));
+    }
+
+    SECTION("torn record is cut off with everything after it")
+    {
+        append_records(dir.path, 1, 5);
+        overwrite(dir.path / "journal.1", 3 * sizeof(JournalRecord) + 24, "garbage"); // amount of lsn 4
+
+        REQUIRE(replayed_lsns(dir.path, 1, next_lsn) == lsn_range(1, 3));
+        REQUIRE(next_lsn == 4);
+        REQUIRE(fs::file_size(dir.path / "journal.1") == 3 * sizeof(JournalRecord));
+
+        SECTION("and the next records continue from its lsn")
+        {
+            append_records(dir.path, next_lsn, 2);
+
+            REQUIRE(replayed_lsns(dir.path, 1, next_lsn) == lsn_range(1, 5));
+            REQUIRE(file_names(dir.path) == set<string>{"journal.1", "journal.4"});
+        }
+    }
+
+    SECTION("partial record at the end is cut off")
+    {
+        append_records(dir.path, 1, 3);
+        append_bytes(dir.path / "journal.1", string(sizeof(JournalRecord) / 2, 'x'));
+
+        REQUIRE(replayed_lsns(dir.path, 1, next_lsn) == lsn_range(1, 3));
+        REQUIRE(next_lsn == 4);
+        REQUIRE(fs::file_size(dir.path / "journal.1") == 3 * sizeof(JournalRecord));
+    }
+
+    SECTION("segments after a gap are removed")
+    {
+        append_records(dir.path, 1, 3);
+        append_records(dir.path, 10, 3); // lsn 4 - 9 are missing
+
+        REQUIRE(replayed_lsns(dir.path, 1, next_lsn) == lsn_range(1, 3));
+        REQUIRE(next_lsn == 4);
+        REQUIRE(file_names(dir.path) == set<string>{"journal.1"});
+    }
+
+    SECTION("segments after a torn record are removed")
+    {
+        append_records(dir.path, 1, 3);
+        append_records(dir.path, 4, 3);
+        append_records(dir.path, 7, 3);
+        overwrite(dir.path / "journal.4", sizeof(JournalRecord), "garbage"); // lsn 5
+
+        REQUIRE(replayed_lsns(dir.path, 1, next_lsn) == lsn_range(1, 4));
+        REQUIRE(file_names(dir.path) == set<string>{"journal.1", "journal.4"});
+        REQUIRE(fs::file_size(dir.path / "journal.4") == sizeof(JournalRecord));
+    }
+
+    SECTION("missing records before the first segment are an error")
+    {
+        append_records(dir.path, 5, 3);
+
+        REQUIRE_THROWS_AS(replayed_lsns(dir.path, 1, next_lsn), runtime_error);
+    }
+
+    SECTION("empty directory replays nothing")
+    {
+        REQUIRE(replayed_lsns(dir.path, 7, next_lsn).empty());
+        REQUIRE(next_lsn == 7);
+    }
+}
+
+TEST_CASE("Journal - segments")
+{
+    TemporaryDirectory dir{"journal_segment_tests"};
+    uint64_t next_lsn = 0;
+
+    {
+        Journal journal{dir.path, 1};
+        for (int64_t lsn = 1; lsn <= 3; ++lsn)
+            journal.wait_durable(journal.append(deposit_record(0, lsn)));
+
+        journal.start_segment();
+
+        for (int64_t lsn = 4; lsn <= 5; ++lsn)
+            journal.wait_durable(journal.append(deposit_record(0, lsn)));
+    }
+
+    SECTION("start_segment() writes the following records to a new file")
+    {
+        REQUIRE(file_names(dir.path) == set<string>{"journal.1", "journal.4"});
+        REQUIRE(fs::file_size(dir.path / "journal.1") == 3 * sizeof(JournalRecord));
+        REQUIRE(fs::file_size(dir.path / "journal.4") == 2 * sizeof(JournalRecord));
+    }
+
+    SECTION("replay continues across segments")
+    {
+        REQUIRE(replayed_lsns(dir.path, 1, next_lsn) == lsn_range(1, 5));
+        REQUIRE(next_lsn == 6);
+    }
+
+    SECTION("replay starts in the middle of a segment")
+    {
+        REQUIRE(replayed_lsns(dir.path, 2, next_lsn) == lsn_range(2, 5));
+        REQUIRE(file_names(dir.path) == set<string>{"journal.1", "journal.4"});
+        REQUIRE(fs::file_size(dir.path / "journal.1") == 3 * sizeof(JournalRecord));
+    }
+
+    SECTION("remove_segments_before() removes only segments covered entirely")
+    {
+        Journal::remove_segments_before(dir.path, 3); // lsn 3 is still needed
+        REQUIRE(file_names(dir.path) == set<string>{"journal.1", "journal.4"});
+
+        Journal::remove_segments_before(dir.path, 4);
+        REQUIRE(file_names(dir.path) == set<string>{"journal.4"});
+        REQUIRE(replayed_lsns(dir.path, 4, next_lsn) == lsn_range(4, 5));
+    }
+
+    SECTION("the last segment is always kept")
+    {
+        Journal::remove_segments_before(dir.path, 100);
+
+        REQUIRE(file_names(dir.path) == set<string>{"journal.4"});
+    }
+}
+
+TEST_CASE("JournaledBank - recovery from a snapshot and the journal tail")
+{
+    TemporaryDirectory dir{"journaled_bank_tests"};
+    const JournaledBankOptions options{.is_group_commit = true, .snapshot_every_records = 0};
+
+    {
+        JournaledBank bank{dir.path, 4, 100, options};
+        bank.deposit(0, 10);
+        bank.transfer(0, 1, 50);
+        REQUIRE(bank.withdraw(2, 1'000) == false); // not journaled
+
+        bank.snapshot();
+
+        bank.deposit(3, 5);
+        bank.transfer(1, 2, 20);
+    }
+
+    SECTION("segments covered by a snapshot are removed once a later segment exists")
+    {
+        // the segment of the snapshot was the last one when it was taken
+        REQUIRE(file_names(dir.path) == set<string>{"journal.1", "journal.3", "snapshot"});
+
+        {
+            JournaledBank bank{dir.path, 4, 100, options}; // starts segment journal.5
+            bank.snapshot();
+        }
+        REQUIRE(file_names(dir.path) == set<string>{"journal.5", "snapshot"});
+
+        JournaledBank bank{dir.path, 4, 100, options};
+        REQUIRE(bank.replayed_records() == 0);
+        REQUIRE(bank.total_balance() == 415);
+    }
+
+    SECTION("only records after the snapshot are replayed")
+    {
+        JournaledBank bank{dir.path, 4, 100, options};
+
+        REQUIRE(bank.replayed_records() == 2);
+        REQUIRE(bank.balance(0) == 60);
+        REQUIRE(bank.balance(1) == 130);
+        REQUIRE(bank.balance(2) == 120);
+        REQUIRE(bank.balance(3) == 105);
+        REQUIRE(bank.total_balance() == 415);
+    }
+
+    SECTION("a torn record of the tail is lost with the records after it")
+    {
+        overwrite(dir.path / "journal.3", 24, "garbage"); // the first record after the snapshot
+
+        {
+            JournaledBank bank{dir.path, 4, 100, options};
+
+            REQUIRE(bank.replayed_records() == 0);
+            REQUIRE(bank.balance(3) == 100);
+            REQUIRE(bank.balance(1) == 150);
+
+            bank.deposit(3, 1); // appended with the lsn of the torn record
+        }
+
+        JournaledBank bank{dir.path, 4, 100, options};
+
+        REQUIRE(bank.replayed_records() == 1);
+        REQUIRE(bank.balance(3) == 101);
+    }
+}
+#endif
@@ -0,0 +1,250 @@
+#include "stm.hpp"
+
+#include <array>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    struct Aborted : runtime_error
+    {
+        Aborted()
+            : runtime_error{"transaction aborted"}
+        {
+        }
+    };
+
+    // commits a write from another thread - as if it happened concurrently at this point of a transaction
+    template <typename T>
+    void set_concurrently(Stm::TVar<T>& var, T value)
+    {
+        thread{[&var, value] { Stm::atomically([&] { var.set(value); }); }}.join();
+    }
+}
+
+TEST_CASE("Stm - single thread")
+{
+    Stm::TVar<int64_t> a{100};
+    Stm::TVar<int64_t> b{0};
+
+    SECTION("committed writes are visible to later transactions")
+    {
+        Stm::atomically([&] {
+            a.set(a.get() - 10);
+            b.set(b.get() + 10);
+        });
+
+        REQUIRE(Stm::atomically([&] { return a.get(); }) == 90);
+        REQUIRE(Stm::atomically([&] { return b.get(); }) == 10);
+    }
+
+    SECTION("a transaction reads its own writes")
+    {
+        const int64_t read = Stm::atomically([&] {
+            a.set(1);
+            a.set(a.get() + 1);
+            return a.get();
+        });
+
+        REQUIRE(read == 2);
+    }
+
+    SECTION("values of other types keep their bits")
+    {
+        Stm::TVar<double> ratio{0.25};
+        Stm::TVar<bool> flag{false};
+
+        Stm::atomically([&] {
+            ratio.set(ratio.get() * -2);
+            flag.set(true);
+        });
+
+        REQUIRE(Stm::atomically([&] { return ratio.get(); }) == -0.5);
+        REQUIRE(Stm::atomically([&] { return flag.get(); }) == true);
+    }
+
+    SECTION("an exception discards all writes of the transaction")
+    {
+        REQUIRE_THROWS_AS(Stm::atomically([&] {
+            a.set(0);
+            b.set(100);
+            throw Aborted{};
+        }),
+            Aborted);
+
+        REQUIRE(Stm::atomically([&] { return a.get() + b.get() * 1000; }) == 100);
+
+        Stm::atomically([&] { b.set(1); }); // the thread is not left inside the aborted transaction
+        REQUIRE(Stm::atomically([&] { return b.get(); }) == 1);
+    }
+
+    SECTION("nested atomically() joins the enclosing transaction")
+    {
+        SECTION("writes are shared in both directions")
+        {
+            Stm::atomically([&] {
+                a.set(50);
+                Stm::atomically([&] { b.set(a.get() + 1); });
+                REQUIRE(b.get() == 51);
+            });
+
+            REQUIRE(Stm::atomically([&] { return b.get(); }) == 51);
+        }
+
+        SECTION("an exception after the nested call discards its writes too")
+        {
+            REQUIRE_THROWS_AS(Stm::atomically([&] {
+                Stm::atomically([&] { b.set(1); });
+                throw Aborted{};
+            }),
+                Aborted);
+
+            REQUIRE(Stm::atomically([&] { return b.get(); }) == 0);
+        }
+
+        SECTION("an exception of the nested call aborts the enclosing transaction")
+        {
+            REQUIRE_THROWS_AS(Stm::atomically([&] {
+                a.set(1);
+                Stm::atomically([&] { throw Aborted{}; });
+            }),
+                Aborted);
+
+            REQUIRE(Stm::atomically([&] { return a.get(); }) == 100);
+        }
+    }
+}
+
+TEST_CASE("Stm - conflicts restart the transaction")
+{
+    Stm::TVar<int64_t> x{1};
+    Stm::TVar<int64_t> y{0};
+
+    SECTION("read of a variable committed after the transaction started")
+    {
+        int attempts = 0;
+
+        const int64_t read = Stm::atomically([&] {
+            if (++attempts == 1)
+                set_concurrently(x, int64_t{2});
+            return x.get();
+        });
+
+        REQUIRE(attempts == 2);
+        REQUIRE(read == 2);
+    }
+
+    SECTION("commit of a transaction whose read has become stale")
+    {
+        int attempts = 0;
+
+        Stm::atomically([&] {
+            const int64_t value = x.get();
+            if (++attempts == 1)
+                set_concurrently(x, int64_t{10});
+            y.set(value * 100);
+        });
+
+        REQUIRE(attempts == 2);
+        REQUIRE(Stm::atomically([&] { return y.get(); }) == 1'000); // not computed from the stale value
+    }
+
+    SECTION("commit of a transaction without conflicting reads")
+    {
+        Stm::TVar<int64_t> unrelated{0};
+        int attempts = 0;
+
+        Stm::atomically([&] {
+            const int64_t value = x.get();
+            if (++attempts == 1)
+                set_concurrently(unrelated, int64_t{5});
+            y.set(value);
+        });
+
+        REQUIRE(attempts == 1);
+    }
+}
+
+TEST_CASE("Stm - concurrent transfers")
+{
+    constexpr int threads_count = 4;
+    constexpr int transfers_per_thread = 20'000;
+    constexpr int64_t initial_balance = 1'000;
+
+    array<Stm::TVar<int64_t>, 8> accounts; // few accounts - many conflicts
+    Stm::atomically([&] {
+        for (auto& account : accounts)
+            account.set(initial_balance);
+    });
+    const int64_t total = initial_balance * static_cast<int64_t>(accounts.size());
+
+    auto sum = [&accounts] {
+        return Stm::atomically([&] {
+            int64_t result = 0;
+            for (const auto& account : accounts)
+                result += account.get();
+            return result;
+        });
+    };
+
+    atomic<bool> is_done{false};
+    bool is_sum_consistent = true;
+    int aborted_count = 0;
+
+    {
+        thread auditor{[&] {
+            while (!is_done.load())
+                is_sum_consistent &= sum() == total; // every snapshot is a committed state
+        }};
+
+        vector<jthread> threads;
+        vector<int> aborted(threads_count);
+        for (int t = 0; t < threads_count; ++t)
+        {
+            threads.emplace_back([&, t] {
+                mt19937_64 rnd{static_cast<uint64_t>(t)};
+                uniform_int_distribution<size_t> account_index{0, accounts.size() - 1};
+                uniform_int_distribution<int64_t> amount_distribution{1, 100};
+
+                for (int i = 0; i < transfers_per_thread; ++i)
+                {
+                    const size_t from = account_index(rnd);
+                    const size_t to = account_index(rnd);
+                    const int64_t amount = amount_distribution(rnd);
+
+                    try
+                    {
+                        Stm::atomically([&] {
+                            accounts[from].set(accounts[from].get() - amount);
+                            if (amount % 4 == 0) // a published half of the transfer would break the conservation
+                                throw Aborted{};
+                            accounts[to].set(accounts[to].get() + amount);
+                        });
+                    }
+                    catch (const Aborted&)
+                    {
+                        ++aborted[t];
+                    }
+                }
+            });
+        }
+
+        threads.clear(); // joins
+        is_done = true;
+        auditor.join();
+
+        for (int count : aborted)
+            aborted_count += count;
+    }
+
+    REQUIRE(aborted_count > 0);
+    REQUIRE(is_sum_consistent);
+    REQUIRE(sum() == total);
+}
@@ -0,0 +1,477 @@
+#include "sharded_queue.hpp"
+#include "thread_safe_priority_queue.hpp"
+#include "thread_safe_queue.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <linux/perf_event.h>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+struct BenchmarkResult
+{
+    double elapsed_ms;
+    double mops_per_sec;
+};
+
+// producers push items_per_producer items each, consumers pop all of them
+template <typename TQueue>
+BenchmarkResult run_producers_consumers(TQueue& queue, int producers_count, int consumers_count, int items_per_producer)
+{
+    const long total = static_cast<long>(producers_count) * items_per_producer;
+
+    vector<thread> threads;
+    threads.reserve(producers_count + consumers_count);
+
+    const auto start = chrono::steady_clock::now();
+
+    for (int c = 0; c < consumers_count; ++c)
+    {
+        const long to_pop = total / consumers_count + (c < total % consumers_count ? 1 : 0);
+        threads.emplace_back([&queue, to_pop] {
+            long item;
+            for (long i = 0; i < to_pop; ++i)
+                queue.pop(item);
+        });
+    }
+
+    for (int p = 0; p < producers_count; ++p)
+    {
+        threads.emplace_back([&queue, items_per_producer] {
+            for (long i = 0; i < items_per_producer; ++i)
+                queue.push(i);
+        });
+    }
+
+    for (auto& thd : threads)
+        thd.join();
+
+    const auto end = chrono::steady_clock::now();
+    const double elapsed_ms = chrono::duration<double, milli>(end - start).count();
+
+    return {elapsed_ms, total / elapsed_ms / 1'000.0};
+}
+
+void benchmark_sharded_queue(long total_items, int max_producers, int consumers_count)
+{
+    cout << "Producers/consumers throughput: ThreadSafeQueue vs. ShardedQueue\n";
+    cout << "  items: " << total_items << "; consumers: " << consumers_count << "\n\n";
+
+    cout << setw(10) << "producers"
+         << setw(18) << "single [Mops/s]"
+         << setw(18) << "sharded [Mops/s]"
+         << setw(10) << "speedup" << "\n";
+
+    for (int producers_count = 1; producers_count <= max_producers; producers_count *= 2)
+    {
+        const int items_per_producer = static_cast<int>(total_items / producers_count);
+
+        ThreadSafeQueue<long> single_queue;
+        const auto single = run_producers_consumers(single_queue, producers_count, consumers_count, items_per_producer);
+
+        ShardedQueue<long> sharded_queue;
+        const auto sharded = run_producers_consumers(sharded_queue, producers_count, consumers_count, items_per_producer);
+
+        cout << setw(10) << producers_count
+             << setw(18) << fixed << setprecision(2) << single.mops_per_sec
+             << setw(18) << sharded.mops_per_sec
+             << setw(9) << sharded.mops_per_sec / single.mops_per_sec << "x" << endl;
+    }
+}
+
+// baseline: std::priority_queue guarded by a single mutex
+template <typename T>
+class LockedPriorityQueue
+{
+public:
+    void push(const T& item)
+    {
+        {
+            std::lock_guard lk{m_mutex};
+            m_queue.push(item);
+        }
+        m_cvNotEmpty.notify_one();
+    }
+
+    void pop(T& item)
+    {
+        std::unique_lock lk{m_mutex};
+        m_cvNotEmpty.wait(lk, [this] { return !m_queue.empty(); });
+        item = m_queue.top();
+        m_queue.pop();
+    }
+
+private:
+    std::priority_queue<T> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_cvNotEmpty;
+};
+
+// every thread alternates push(random priority) and pop on a prefilled queue
+template <typename TPriorityQueue>
+double run_push_pop_mix(TPriorityQueue& queue, int threads_count, int ops_per_thread, int prefill)
+{
+    std::mt19937 rnd_gen{42};
+    for (int i = 0; i < prefill; ++i)
+        queue.push(static_cast<long>(rnd_gen()));
+
+    vector<thread> threads;
+    threads.reserve(threads_count);
+
+    const auto start = chrono::steady_clock::now();
+
+    for (int t = 0; t < threads_count; ++t)
+    {
+        threads.emplace_back([&queue, ops_per_thread, t] {
+            std::mt19937 rnd_gen(t);
+            long item;
+            for (int i = 0; i < ops_per_thread; ++i)
+            {
+                queue.push(static_cast<long>(rnd_gen()));
+                queue.pop(item);
+            }
+        });
+    }
+
+    for (auto& thd : threads)
+        thd.join();
+
+    const auto end = chrono::steady_clock::now();
+    const double elapsed_ms = chrono::duration<double, milli>(end - start).count();
+
+    return 2.0 * threads_count * ops_per_thread / elapsed_ms / 1'000.0;
+}
+
+struct RankError
+{
+    double mean;
+    long max;
+};
+
+// rank error of a pop = number of items with higher priority still in the queue
+RankError measure_rank_error(size_t heaps_count, int items_count)
+{
+    ThreadSafePriorityQueue<long> queue{heaps_count};
+
+    vector<long> items(items_count);
+    iota(items.begin(), items.end(), 0);
+    shuffle(items.begin(), items.end(), std::mt19937{42});
+    for (long item : items)
+        queue.push(item);
+
+    // Fenwick tree over priorities of items that are still in the queue
+    vector<long> tree(items_count + 1);
+    auto update = [&tree](long index, long delta) {
+        for (++index; index < static_cast<long>(tree.size()); index += index & -index)
+            tree[index] += delta;
+    };
+    auto prefix_sum = [&tree](long index) {
+        long sum = 0;
+        for (++index; index > 0; index -= index & -index)
+            sum += tree[index];
+        return sum;
+    };
+
+    for (long i = 0; i < items_count; ++i)
+        update(i, 1);
+
+    long remaining = items_count;
+    long sum_of_errors = 0;
+    long max_error = 0;
+
+    long item;
+    while (queue.try_pop(item))
+    {
+        const long rank_error = remaining - prefix_sum(item);
+        sum_of_errors += rank_error;
+        max_error = max(max_error, rank_error);
+        update(item, -1);
+        --remaining;
+    }
+
+    return {static_cast<double>(sum_of_errors) / items_count, max_error};
+}
+
+void benchmark_priority_queue(int max_threads, int ops_per_thread)
+{
+    cout << "\nPriority queue throughput (push + pop per op): single-lock std::priority_queue vs. ThreadSafePriorityQueue\n";
+    cout << "  ops per thread: " << ops_per_thread << "\n\n";
+
+    cout << setw(10) << "threads"
+         << setw(18) << "locked [Mops/s]"
+         << setw(18) << "multi [Mops/s]"
+         << setw(10) << "speedup" << "\n";
+
+    for (int threads_count = 1; threads_count <= max_threads; threads_count *= 2)
+    {
+        LockedPriorityQueue<long> locked_queue;
+        const double locked = run_push_pop_mix(locked_queue, threads_count, ops_per_thread, 10'000);
+
+        ThreadSafePriorityQueue<long> multi_queue{ThreadSafePriorityQueue<long>::heaps_count_for(threads_count)};
+        const double multi = run_push_pop_mix(multi_queue, threads_count, ops_per_thread, 10'000);
+
+        cout << setw(10) << threads_count
+             << setw(18) << fixed << setprecision(2) << locked
+             << setw(18) << multi
+             << setw(9) << multi / locked << "x" << endl;
+    }
+
+    const int items_count = 100'000;
+    cout << "\nPriority queue ordering quality (" << items_count << " items, rank error of each pop)\n\n";
+    cout << setw(10) << "heaps" << setw(14) << "mean rank" << setw(14) << "max rank" << "\n";
+
+    for (size_t heaps_count : {1, 2, 4, 8, 16, 32, 64})
+    {
+        const auto [mean, max_error] = measure_rank_error(heaps_count, items_count);
+        cout << setw(10) << heaps_count << setw(14) << setprecision(2) << mean << setw(14) << max_error << endl;
+    }
+}
+
+// baseline: previous ThreadSafeQueue signalling with std::condition_variable
+template <typename T>
+class CondVarQueue
+{
+public:
+    void push(const T& item)
+    {
+        {
+            std::lock_guard lk{m_mutex};
+            m_queue.push(item);
+        }
+        m_cvNotEmpty.notify_one();
+    }
+
+    void pop(T& item)
+    {
+        std::unique_lock lk{m_mutex};
+        m_cvNotEmpty.wait(lk, [this] { return !m_queue.empty(); });
+        item = m_queue.front();
+        m_queue.pop();
+    }
+
+private:
+    std::queue<T> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_cvNotEmpty;
+};
+
+long context_switches()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+// Kernel tracepoint (e.g. syscalls:sys_enter_futex) counted for the whole process with perf_event_open.
+// Threads created after start() are counted as well - their counts are added when they exit.
+// Needs tracefs and perf_event_paranoid <= 1 (or CAP_PERFMON) - otherwise stop() returns no value.
+class TracepointCounter
+{
+public:
+    TracepointCounter(const string& category, const string& name)
+    {
+        for (const string tracefs : {"/sys/kernel/tracing", "/sys/kernel/debug/tracing"})
+        {
+            ifstream id_file{tracefs + "/events/" + category + "/" + name + "/id"};
+            uint64_t id;
+            if (id_file >> id)
+            {
+                m_fd = open_tracepoint(id);
+                break;
+            }
+        }
+    }
+
+    TracepointCounter(const TracepointCounter&) = delete;
+    TracepointCounter& operator=(const TracepointCounter&) = delete;
+
+    ~TracepointCounter()
+    {
+        if (m_fd != -1)
+            close(m_fd);
+    }
+
+    void start()
+    {
+        if (m_fd == -1)
+            return;
+
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    optional<uint64_t> stop()
+    {
+        if (m_fd == -1)
+            return nullopt;
+
+        ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        uint64_t count;
+        if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+            return nullopt;
+        return count;
+    }
+
+private:
+    int m_fd = -1;
+
+    static int open_tracepoint(uint64_t id)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.config = id;
+        attr.disabled = 1;
+        attr.inherit = 1;
+
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC)); // this process, any CPU
+    }
+};
+
+// single thread, nobody waits - cost of push + pop pair
+template <typename TQueue>
+double uncontended_push_pop_ns(int iterations)
+{
+    TQueue queue;
+    long item;
+
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        queue.push(i);
+        queue.pop(item);
+    }
+    const auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double, nano>(end - start).count() / iterations;
+}
+
+struct PingPongResult
+{
+    double round_trip_ns;
+    double context_switches_per_round_trip;
+    optional<double> syscalls_per_round_trip; // empty when tracepoints cannot be counted
+    optional<double> futex_calls_per_round_trip;
+};
+
+// two threads bounce a token through a pair of queues - every pop has to wait for the other side
+template <typename TQueue>
+PingPongResult ping_pong(int round_trips)
+{
+    TQueue ping;
+    TQueue pong;
+
+    TracepointCounter syscalls{"raw_syscalls", "sys_enter"};
+    TracepointCounter futex_calls{"syscalls", "sys_enter_futex"};
+
+    const long switches_before = context_switches();
+    syscalls.start();
+    futex_calls.start();
+    const auto start = chrono::steady_clock::now();
+
+    thread responder{[&] {
+        long token;
+        for (int i = 0; i < round_trips; ++i)
+        {
+            ping.pop(token);
+            pong.push(token);
+        }
+    }};
+
+    long token;
+    for (int i = 0; i < round_trips; ++i)
+    {
+        ping.push(i);
+        pong.pop(token);
+    }
+    responder.join();
+
+    const auto end = chrono::steady_clock::now();
+    const optional<uint64_t> futex_calls_count = futex_calls.stop();
+    const optional<uint64_t> syscalls_count = syscalls.stop();
+    const long switches = context_switches() - switches_before;
+
+    const auto per_round_trip = [round_trips](optional<uint64_t> count) -> optional<double> {
+        if (!count)
+            return nullopt;
+        return static_cast<double>(*count) / round_trips;
+    };
+
+    return {chrono::duration<double, nano>(end - start).count() / round_trips, static_cast<double>(switches) / round_trips,
+        per_round_trip(syscalls_count), per_round_trip(futex_calls_count)};
+}
+
+template <typename TQueue>
+void print_signalling_results(const string& name, int iterations)
+{
+    const double push_pop_ns = uncontended_push_pop_ns<TQueue>(iterations);
+    const auto [round_trip_ns, switches, syscalls, futex_calls] = ping_pong<TQueue>(iterations / 10);
+    const auto throughput = [iterations] {
+        TQueue queue;
+        return run_producers_consumers(queue, 4, 4, iterations / 4);
+    }();
+
+    cout << setw(24) << name
+         << setw(16) << fixed << setprecision(1) << push_pop_ns
+         << setw(16) << round_trip_ns
+         << setw(16) << setprecision(3) << switches;
+
+    for (const optional<double>& count : {syscalls, futex_calls})
+    {
+        if (count)
+            cout << setw(16) << *count;
+        else
+            cout << setw(16) << "n/a";
+    }
+
+    cout << setw(16) << setprecision(2) << throughput.mops_per_sec << endl;
+}
+
+void benchmark_signalling(int iterations)
+{
+    cout << "\nSignalling: std::condition_variable vs. EventCount (atomic wait/notify)\n";
+    cout << "  syscalls/trip, futex/trip - kernel entries per ping-pong round trip counted with perf_event_open\n"
+         << "  (n/a without tracefs or with kernel.perf_event_paranoid > 1)\n\n";
+
+    cout << setw(24) << "queue"
+         << setw(16) << "push+pop [ns]"
+         << setw(16) << "ping-pong [ns]"
+         << setw(16) << "ctx sw/trip"
+         << setw(16) << "syscalls/trip"
+         << setw(16) << "futex/trip"
+         << setw(16) << "4x4 [Mops/s]" << "\n";
+
+    print_signalling_results<CondVarQueue<long>>("condition_variable", iterations);
+    print_signalling_results<ThreadSafeQueue<long>>("ThreadSafeQueue", iterations);
+}
+
+int main(int argc, char* argv[])
+{
+    // usage: thread_safe_queue_benchmarks [total_items] [max_producers] [consumers]
+    const long total_items = argc > 1 ? stol(argv[1]) : 1'000'000;
+    const int max_producers = argc > 2 ? stoi(argv[2]) : 64;
+    const int consumers_count = argc > 3 ? stoi(argv[3]) : max(static_cast<int>(thread::hardware_concurrency()) / 2, 1);
+
+    benchmark_sharded_queue(total_items, max_producers, consumers_count);
+    benchmark_priority_queue(max_producers, static_cast<int>(total_items / max_producers));
+    benchmark_signalling(static_cast<int>(total_items));
+}
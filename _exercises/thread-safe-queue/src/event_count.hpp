@@ -0,0 +1,96 @@
+#ifndef EVENT_COUNT_HPP
+#define EVENT_COUNT_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Notification layer for blocking queues built on std::atomic::wait/notify (futex on Linux).
+//
+// Waiters register themselves before the final check of the waited condition,
+// so notifiers make a syscall only when a registered waiter has not been signalled yet:
+//
+//   consumer:                                  producer:
+//     auto key = ec.prepare_wait();              publish item (e.g. under mutex)
+//     if (condition) ec.cancel_wait();           ec.notify_one();
+//     else ec.wait(key);
+//
+// The sequence counter is bumped on every notification - a waiter whose key is stale
+// does not go to sleep at all, so no wake-up is lost.
+class EventCount
+{
+public:
+    using Key = std::uint32_t;
+
+    [[nodiscard]] Key prepare_wait()
+    {
+        m_state.fetch_add(1); // one more waiter
+        return m_seq.load();
+    }
+
+    void cancel_wait()
+    {
+        leave();
+    }
+
+    void wait(Key key)
+    {
+        m_seq.wait(key);
+        leave();
+    }
+
+    void notify_one()
+    {
+        m_seq.fetch_add(1);
+        if (claim_waiters(false))
+            m_seq.notify_one();
+    }
+
+    void notify_all()
+    {
+        m_seq.fetch_add(1);
+        if (claim_waiters(true))
+            m_seq.notify_all();
+    }
+
+private:
+    static constexpr unsigned signals_shift = 32;
+    static constexpr std::uint64_t waiters_mask = 0xFFFF'FFFF;
+
+    std::atomic<Key> m_seq{};
+    // low 32 bits: registered waiters; high 32 bits: signals sent to them and not consumed yet
+    // (a woken thread may not run for a while - further pushes must not wake it again)
+    std::atomic<std::uint64_t> m_state{};
+
+    bool claim_waiters(bool all)
+    {
+        std::uint64_t state = m_state.load();
+        while (true)
+        {
+            const std::uint64_t waiters = state & waiters_mask;
+            const std::uint64_t signals = state >> signals_shift;
+
+            if (waiters <= signals)
+                return false; // nobody to wake - no syscall
+
+            const std::uint64_t new_signals = all ? waiters : signals + 1;
+            if (m_state.compare_exchange_weak(state, (new_signals << signals_shift) | waiters))
+                return true;
+        }
+    }
+
+    void leave()
+    {
+        std::uint64_t state = m_state.load();
+        while (true)
+        {
+            const std::uint64_t waiters = state & waiters_mask;
+            const std::uint64_t signals = state >> signals_shift;
+            const std::uint64_t new_signals = signals > 0 ? signals - 1 : 0;
+
+            if (m_state.compare_exchange_weak(state, (new_signals << signals_shift) | (waiters - 1)))
+                return;
+        }
+    }
+};
+
+#endif // EVENT_COUNT_HPP
@@ -0,0 +1,176 @@
+#ifndef SHARDED_QUEUE_HPP
+#define SHARDED_QUEUE_HPP
+
+#include "cache_line.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+// Relaxed-FIFO queue: items are spread over K independent sub-queues (shards),
+// each protected by its own mutex, so producers do not fight for one lock.
+//
+// Ordering guarantee:
+//  - every producer thread sticks to one shard (round-robin assignment on the first push),
+//    so items pushed by the same thread are popped in the order they were pushed
+//  - there is NO ordering between items pushed by different threads
+//
+// Consumers use the "power of two choices": two random shards are sampled and the longer one is popped.
+template <typename T>
+class ShardedQueue
+{
+public:
+    explicit ShardedQueue(size_t shard_count = 2 * std::max(std::thread::hardware_concurrency(), 1u))
+        : m_shards(std::max<size_t>(shard_count, 1))
+    {
+    }
+
+    ShardedQueue(const ShardedQueue&) = delete;
+    ShardedQueue& operator=(const ShardedQueue&) = delete;
+
+    size_t shard_count() const
+    {
+        return m_shards.size();
+    }
+
+    bool empty() const
+    {
+        return m_size.load() == 0;
+    }
+
+    void push(const T& item)
+    {
+        Shard& shard = producer_shard();
+        {
+            std::lock_guard lk{shard.mtx};
+            shard.items.push(item);
+            shard.size.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_size.fetch_add(1);
+        m_itemsAvailable.release();
+    }
+
+    void push(T&& item)
+    {
+        Shard& shard = producer_shard();
+        {
+            std::lock_guard lk{shard.mtx};
+            shard.items.push(std::move(item));
+            shard.size.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_size.fetch_add(1);
+        m_itemsAvailable.release();
+    }
+
+    void push(const std::vector<T>& items)
+    {
+        if (items.empty())
+            return;
+
+        Shard& shard = producer_shard();
+        {
+            std::lock_guard lk{shard.mtx};
+            for (const auto& item : items)
+            {
+                shard.items.push(item);
+            }
+            shard.size.fetch_add(items.size(), std::memory_order_relaxed);
+        }
+        m_size.fetch_add(items.size());
+        m_itemsAvailable.release(static_cast<std::ptrdiff_t>(items.size()));
+    }
+
+    void pop(T& item)
+    {
+        m_itemsAvailable.acquire(); // reserves one item - it is guaranteed to be in one of the shards
+        take_reserved(item);
+    }
+
+    bool try_pop(T& item)
+    {
+        if (!m_itemsAvailable.try_acquire())
+            return false;
+
+        take_reserved(item);
+        return true;
+    }
+
+private:
+    struct alignas(cache_line_size) Shard
+    {
+        std::mutex mtx;
+        std::queue<T> items;
+        std::atomic<size_t> size{}; // read without lock by consumers sampling shards
+    };
+
+    std::vector<Shard> m_shards;
+    alignas(cache_line_size) std::atomic<size_t> m_size{};
+    std::counting_semaphore<> m_itemsAvailable{0};
+
+    inline static std::atomic<size_t> s_nextProducerTicket{};
+
+    Shard& producer_shard()
+    {
+        thread_local const size_t ticket = s_nextProducerTicket.fetch_add(1, std::memory_order_relaxed);
+        return m_shards[ticket % m_shards.size()];
+    }
+
+    static size_t random_index(size_t n)
+    {
+        thread_local std::minstd_rand rnd_gen{static_cast<std::minstd_rand::result_type>(std::hash<std::thread::id>{}(std::this_thread::get_id()))};
+        return rnd_gen() % n;
+    }
+
+    bool try_take_from(Shard& shard, T& item)
+    {
+        if (shard.size.load(std::memory_order_relaxed) == 0)
+            return false;
+
+        std::lock_guard lk{shard.mtx};
+        if (shard.items.empty())
+            return false;
+
+        item = std::move(shard.items.front());
+        shard.items.pop();
+        shard.size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void take_reserved(T& item)
+    {
+        const size_t n = m_shards.size();
+
+        while (true)
+        {
+            // power of two choices
+            Shard& first = m_shards[random_index(n)];
+            Shard& second = m_shards[random_index(n)];
+            Shard& longer = first.size.load(std::memory_order_relaxed) >= second.size.load(std::memory_order_relaxed) ? first : second;
+
+            if (try_take_from(longer, item))
+                break;
+
+            // both samples were empty - sweep all shards starting from a random one
+            bool taken = false;
+            const size_t start = random_index(n);
+            for (size_t i = 0; i < n && !taken; ++i)
+                taken = try_take_from(m_shards[(start + i) % n], item);
+
+            if (taken)
+                break;
+
+            std::this_thread::yield(); // sweep raced with concurrent pushes/pops - the reserved item is still there, retry
+        }
+
+        m_size.fetch_sub(1);
+    }
+};
+
+#endif // SHARDED_QUEUE_HPP
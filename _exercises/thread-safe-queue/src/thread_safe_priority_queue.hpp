@@ -0,0 +1,286 @@
+#ifndef THREAD_SAFE_PRIORITY_QUEUE_HPP
+#define THREAD_SAFE_PRIORITY_QUEUE_HPP
+
+#include "cache_line.hpp"
+#include "event_count.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Concurrent priority queue built as a MultiQueue: K binary heaps, each with its own mutex.
+//
+// As in std::priority_queue the item with the highest priority is the "largest" one
+// according to Compare (std::less<T> gives a max-heap).
+//
+// Ordering is relaxed: push goes to a random heap, pop compares the tops of two different random heaps
+// and takes the better one. The popped item is not always the global top, but its expected rank
+// (number of better items still in the queue) is O(K) - see queue_benchmarks for measurements.
+// K should therefore be as small as contention allows - heaps_count_for() gives 2 heaps per consumer.
+template <typename T, typename Compare = std::less<T>>
+class ThreadSafePriorityQueue
+{
+public:
+    using value_type = T;
+
+    static constexpr size_t default_consumers_count = 2;
+
+    // 2 heaps per consumer thread keep contention low - more heaps only make the order more random
+    static size_t heaps_count_for(size_t consumers_count)
+    {
+        return std::clamp<size_t>(2 * consumers_count, 1, 2 * std::max(std::thread::hardware_concurrency(), 1u));
+    }
+
+    explicit ThreadSafePriorityQueue(size_t heaps_count = heaps_count_for(default_consumers_count), Compare compare = Compare{})
+        : m_heaps(std::max<size_t>(heaps_count, 1))
+        , m_compare(std::move(compare))
+    {
+    }
+
+    ThreadSafePriorityQueue(const ThreadSafePriorityQueue&) = delete;
+    ThreadSafePriorityQueue& operator=(const ThreadSafePriorityQueue&) = delete;
+
+    bool empty() const
+    {
+        return (m_available.load() & ~closed_bit) == 0;
+    }
+
+    void push(const T& item)
+    {
+        if (!try_push(item))
+            throw std::logic_error("push to closed ThreadSafePriorityQueue");
+    }
+
+    void push(T&& item)
+    {
+        if (!try_push(std::move(item)))
+            throw std::logic_error("push to closed ThreadSafePriorityQueue");
+    }
+
+    void push(const std::vector<T>& items)
+    {
+        if (!try_announce(items.size()))
+            throw std::logic_error("push to closed ThreadSafePriorityQueue");
+
+        for (const auto& item : items)
+        {
+            auto [heap, lk] = lock_random_heap();
+            heap.push(item, m_compare);
+        }
+        m_itemsAvailable.notify_all();
+    }
+
+    // returns false if the queue is closed
+    bool try_push(const T& item)
+    {
+        if (!try_announce(1))
+            return false;
+
+        {
+            auto [heap, lk] = lock_random_heap();
+            heap.push(item, m_compare);
+        }
+        m_itemsAvailable.notify_one();
+        return true;
+    }
+
+    bool try_push(T&& item)
+    {
+        if (!try_announce(1))
+            return false;
+
+        {
+            auto [heap, lk] = lock_random_heap();
+            heap.push(std::move(item), m_compare);
+        }
+        m_itemsAvailable.notify_one();
+        return true;
+    }
+
+    // returns false when the queue is closed and all remaining items have been popped
+    bool pop(T& item)
+    {
+        while (!try_reserve())
+        {
+            const auto key = m_itemsAvailable.prepare_wait();
+
+            if (try_reserve())
+            {
+                m_itemsAvailable.cancel_wait();
+                break;
+            }
+
+            if (is_closed())
+            {
+                m_itemsAvailable.cancel_wait();
+                return false;
+            }
+
+            m_itemsAvailable.wait(key);
+        }
+
+        take_reserved(item);
+        return true;
+    }
+
+    bool try_pop(T& item)
+    {
+        if (!try_reserve())
+            return false;
+
+        take_reserved(item);
+        return true;
+    }
+
+    // wakes up all blocked consumers - items already in the queue can still be popped,
+    // pushes fail from now on (the closed flag and the count of items are one atomic, so no push can succeed unseen)
+    void close()
+    {
+        m_available.fetch_or(closed_bit);
+        m_itemsAvailable.notify_all();
+    }
+
+    bool is_closed() const
+    {
+        return (m_available.load() & closed_bit) != 0;
+    }
+
+private:
+    struct alignas(cache_line_size) Heap
+    {
+        std::mutex mtx;
+        std::vector<T> items;
+
+        template <typename TItem>
+        void push(TItem&& item, const Compare& compare)
+        {
+            items.push_back(std::forward<TItem>(item));
+            std::push_heap(items.begin(), items.end(), compare);
+        }
+
+        void pop(T& item, const Compare& compare)
+        {
+            std::pop_heap(items.begin(), items.end(), compare);
+            item = std::move(items.back()); // top() of std::priority_queue is const - items would have to be copied
+            items.pop_back();
+        }
+    };
+
+    std::vector<Heap> m_heaps;
+    Compare m_compare;
+    static constexpr size_t closed_bit = size_t{1} << (std::numeric_limits<size_t>::digits - 1);
+
+    // items announced by producers and not reserved by consumers | closed_bit
+    alignas(cache_line_size) std::atomic<size_t> m_available{};
+    EventCount m_itemsAvailable;
+
+    // announces items before they are pushed to heaps - fails if the queue is closed
+    bool try_announce(size_t count)
+    {
+        size_t available = m_available.load();
+        while (!(available & closed_bit))
+        {
+            if (m_available.compare_exchange_weak(available, available + count))
+                return true;
+        }
+        return false;
+    }
+
+    // reserves one item - it is in one of the heaps or its producer is about to push it
+    bool try_reserve()
+    {
+        size_t available = m_available.load();
+        while ((available & ~closed_bit) > 0)
+        {
+            if (m_available.compare_exchange_weak(available, available - 1))
+                return true;
+        }
+        return false;
+    }
+
+    static size_t random_index(size_t n)
+    {
+        thread_local std::minstd_rand rnd_gen{static_cast<std::minstd_rand::result_type>(std::hash<std::thread::id>{}(std::this_thread::get_id()))};
+        return rnd_gen() % n;
+    }
+
+    std::pair<Heap&, std::unique_lock<std::mutex>> lock_random_heap()
+    {
+        const size_t n = m_heaps.size();
+
+        // skip heaps locked by other threads instead of queueing on their mutexes
+        for (size_t attempt = 0; attempt < 2 * n; ++attempt)
+        {
+            Heap& heap = m_heaps[random_index(n)];
+            std::unique_lock lk{heap.mtx, std::try_to_lock};
+            if (lk.owns_lock())
+                return {heap, std::move(lk)};
+        }
+
+        // all heaps seem busy (e.g. a preempted holder) - block instead of spinning
+        Heap& heap = m_heaps[random_index(n)];
+        return {heap, std::unique_lock{heap.mtx}};
+    }
+
+    void take_reserved(T& item)
+    {
+        const size_t n = m_heaps.size();
+
+        // power of two choices - compare tops of two different random heaps (with 2 heaps the order is exact without contention)
+        for (size_t attempt = 0; attempt < 2 * n; ++attempt)
+        {
+            const size_t first_index = random_index(n);
+            Heap& first = m_heaps[first_index];
+            Heap& second = n > 1 ? m_heaps[(first_index + 1 + random_index(n - 1)) % n] : first;
+
+            std::unique_lock lk_first{first.mtx, std::try_to_lock};
+            if (!lk_first.owns_lock())
+                continue;
+
+            std::unique_lock<std::mutex> lk_second;
+            if (&second != &first)
+            {
+                lk_second = std::unique_lock{second.mtx, std::try_to_lock};
+                if (!lk_second.owns_lock())
+                    continue;
+            }
+
+            Heap* better = nullptr;
+            if (!first.items.empty())
+                better = &first;
+            if (!second.items.empty() && (!better || m_compare(better->items.front(), second.items.front())))
+                better = &second;
+
+            if (better)
+            {
+                better->pop(item, m_compare);
+                return;
+            }
+        }
+
+        // queue is almost empty - sweep all heaps until the reserved item is found
+        for (size_t i = 0;; i = (i + 1) % n)
+        {
+            {
+                std::lock_guard lk{m_heaps[i].mtx};
+                if (!m_heaps[i].items.empty())
+                {
+                    m_heaps[i].pop(item, m_compare);
+                    return;
+                }
+            }
+
+            if (i == n - 1)
+                std::this_thread::yield(); // the item is announced but not pushed yet
+        }
+    }
+};
+
+#endif // THREAD_SAFE_PRIORITY_QUEUE_HPP
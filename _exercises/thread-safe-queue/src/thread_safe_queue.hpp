@@ -1,14 +1,19 @@
 #ifndef THREAD_SAFE_QUEUE_HPP
 #define THREAD_SAFE_QUEUE_HPP
 
-#include <condition_variable>
+#include "event_count.hpp"
+
 #include <mutex>
 #include <queue>
+#include <stdexcept>
+#include <vector>
 
 template <typename T>
 class ThreadSafeQueue
 {
 public:
+    using value_type = T;
+
     bool empty() const
     {
         std::lock_guard lk{m_queueMutex};
@@ -17,11 +22,14 @@ public:
 
     void push(const T& item)
     {
-        {
-            std::lock_guard lg{m_queueMutex};
-            m_queue.push(item);
-        }
-        m_cvQueueNotEmpty.notify_one();
+        if (!try_push(item))
+            throw std::logic_error("push to closed ThreadSafeQueue");
+    }
+
+    void push(T&& item)
+    {
+        if (!try_push(std::move(item)))
+            throw std::logic_error("push to closed ThreadSafeQueue");
     }
 
     void push(const std::vector<T>& items)
@@ -32,25 +40,76 @@ public:
         // }
         {
             std::lock_guard lk{m_queueMutex};
+            if (m_isClosed)
+                throw std::logic_error("push to closed ThreadSafeQueue");
+
             for (const auto& item : items)
             {
                 m_queue.push(item);
             }
         }
-        m_cvQueueNotEmpty.notify_all();
+        m_queueNotEmpty.notify_all();
     }
 
-    void pop(T& item)
+    // returns false if the queue is closed
+    bool try_push(const T& item)
     {
-        std::unique_lock ul{m_queueMutex};
-        // while (m_queue.empty())
-        // {
-        //     m_cvQueueNotEmpty.wait(ul);
-        // }
-        m_cvQueueNotEmpty.wait(ul, [this] { return !m_queue.empty(); });
+        {
+            std::lock_guard lg{m_queueMutex};
+            if (m_isClosed)
+                return false;
+            m_queue.push(item);
+        }
+        m_queueNotEmpty.notify_one();
+        return true;
+    }
 
-        item = m_queue.front();
-        m_queue.pop();
+    bool try_push(T&& item)
+    {
+        {
+            std::lock_guard lg{m_queueMutex};
+            if (m_isClosed)
+                return false;
+            m_queue.push(std::move(item));
+        }
+        m_queueNotEmpty.notify_one();
+        return true;
+    }
+
+    // returns false when the queue is closed and all remaining items have been popped
+    bool pop(T& item)
+    {
+        PopStatus status;
+        while ((status = pop_if_not_empty(item)) == PopStatus::empty)
+        {
+            const auto key = m_queueNotEmpty.prepare_wait();
+
+            if ((status = pop_if_not_empty(item)) != PopStatus::empty)
+            {
+                m_queueNotEmpty.cancel_wait();
+                break;
+            }
+
+            m_queueNotEmpty.wait(key); // sleeps without holding the mutex
+        }
+
+        return status == PopStatus::popped;
+    }
+
+    // wakes up all blocked consumers - items already in the queue can still be popped
+    void close()
+    {
+        {
+            std::lock_guard lk{m_queueMutex};
+            m_isClosed = true;
+        }
+        m_queueNotEmpty.notify_all();
+    }
+
+    bool is_closed() const
+    {
+        std::lock_guard lk{m_queueMutex};
+        return m_isClosed;
     }
 
     bool try_pop(T& item)
@@ -60,7 +119,7 @@ public:
         if (!lk.owns_lock() || m_queue.empty())
             return false;
 
-        item = m_queue.front();
+        item = std::move(m_queue.front());
         m_queue.pop();
 
         return true;
@@ -69,7 +128,28 @@ public:
 private:
     std::queue<T> m_queue;
     mutable std::mutex m_queueMutex;
-    std::condition_variable m_cvQueueNotEmpty;
+    EventCount m_queueNotEmpty; // push makes no syscall when no consumer is waiting
+    bool m_isClosed = false;
+
+    enum class PopStatus
+    {
+        popped,
+        empty,
+        closed
+    };
+
+    PopStatus pop_if_not_empty(T& item)
+    {
+        std::lock_guard lk{m_queueMutex};
+
+        if (m_queue.empty())
+            return m_isClosed ? PopStatus::closed : PopStatus::empty;
+
+        item = std::move(m_queue.front());
+        m_queue.pop();
+
+        return PopStatus::popped;
+    }
 };
 
 #endif // THREAD_SAFE_QUEUE_HPP
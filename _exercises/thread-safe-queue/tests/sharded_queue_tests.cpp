@@ -0,0 +1,115 @@
+#include "sharded_queue.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+TEST_CASE("ShardedQueue")
+{
+    ShardedQueue<int> sq{4};
+
+    SECTION("is empty after creation")
+    {
+        REQUIRE(sq.empty() == true);
+        REQUIRE(sq.shard_count() == 4);
+    }
+
+    SECTION("is not empty after push")
+    {
+        sq.push(1);
+
+        REQUIRE(sq.empty() == false);
+    }
+
+    SECTION("try_pop returns false when last item removed")
+    {
+        sq.push(1);
+
+        int item;
+        REQUIRE(sq.try_pop(item));
+        REQUIRE(item == 1);
+        REQUIRE(sq.try_pop(item) == false);
+        REQUIRE(sq.empty() == true);
+    }
+
+    SECTION("items pushed by one thread are popped in FIFO order")
+    {
+        for (int i = 1; i <= 100; ++i)
+            sq.push(i);
+
+        vector<int> popped;
+        int item;
+        while (sq.try_pop(item))
+            popped.push_back(item);
+
+        REQUIRE(popped.size() == 100);
+        REQUIRE(is_sorted(popped.begin(), popped.end()));
+    }
+
+    SECTION("client waits when poping from empty")
+    {
+        int item = 0;
+
+        thread thd{[&sq, &item] { sq.pop(item); }};
+
+        this_thread::sleep_for(100ms);
+        sq.push(42);
+        thd.join();
+
+        REQUIRE(item == 42);
+    }
+
+    SECTION("many producers and consumers - every item is popped exactly once")
+    {
+        const int producers_count = 8;
+        const int consumers_count = 4;
+        const int items_per_producer = 10'000;
+        const int total = producers_count * items_per_producer;
+
+        vector<vector<int>> popped(consumers_count);
+        vector<thread> threads;
+
+        for (int c = 0; c < consumers_count; ++c)
+            threads.emplace_back([&sq, &popped, c] {
+                for (int i = 0; i < total / consumers_count; ++i)
+                {
+                    int item;
+                    sq.pop(item);
+                    popped[c].push_back(item);
+                }
+            });
+
+        for (int p = 0; p < producers_count; ++p)
+            threads.emplace_back([&sq, p] {
+                for (int i = 0; i < items_per_producer; ++i)
+                    sq.push(p * items_per_producer + i);
+            });
+
+        for (auto& thd : threads)
+            thd.join();
+
+        vector<int> all;
+        for (const auto& items : popped)
+        {
+            // relaxed FIFO: items of a single producer keep their relative order in every consumer
+            for (int p = 0; p < producers_count; ++p)
+            {
+                vector<int> from_producer;
+                copy_if(items.begin(), items.end(), back_inserter(from_producer), [p](int x) { return x / items_per_producer == p; });
+                REQUIRE(is_sorted(from_producer.begin(), from_producer.end()));
+            }
+            all.insert(all.end(), items.begin(), items.end());
+        }
+
+        sort(all.begin(), all.end());
+        vector<int> expected(total);
+        iota(expected.begin(), expected.end(), 0);
+        REQUIRE(all == expected);
+        REQUIRE(sq.empty());
+    }
+}
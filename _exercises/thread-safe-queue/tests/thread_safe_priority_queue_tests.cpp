@@ -0,0 +1,213 @@
+#include "thread_safe_priority_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+TEST_CASE("ThreadSafePriorityQueue")
+{
+    SECTION("with single heap")
+    {
+        ThreadSafePriorityQueue<int> pq{1};
+
+        SECTION("is empty after creation")
+        {
+            REQUIRE(pq.empty() == true);
+        }
+
+        SECTION("pops items in priority order")
+        {
+            for (int x : {3, 1, 4, 1, 5, 9, 2, 6})
+                pq.push(x);
+
+            vector<int> popped;
+            int item;
+            while (pq.try_pop(item))
+                popped.push_back(item);
+
+            REQUIRE(popped == vector{9, 6, 5, 4, 3, 2, 1, 1});
+            REQUIRE(pq.empty() == true);
+        }
+    }
+
+    SECTION("pops a small backlog of a single consumer in priority order")
+    {
+        ThreadSafePriorityQueue<int> pq{ThreadSafePriorityQueue<int>::heaps_count_for(1)};
+
+        const vector<int> priorities = {1, 5, 3, 10, 2, 7, 4, 9, 8, 6};
+        for (int x : priorities)
+            pq.push(x);
+
+        // rank error of a pop = number of items with higher priority still in the queue
+        vector<int> remaining = priorities;
+        int max_rank_error = 0;
+        int item;
+        while (pq.try_pop(item))
+        {
+            max_rank_error = max(max_rank_error, static_cast<int>(count_if(remaining.begin(), remaining.end(), [item](int x) { return x > item; })));
+            remaining.erase(find(remaining.begin(), remaining.end(), item));
+        }
+
+        REQUIRE(remaining.empty());
+        REQUIRE(max_rank_error == 0);
+    }
+
+    SECTION("keeps the mean rank error of many heaps in O(number of heaps)")
+    {
+        const size_t heaps_count = 8;
+        const int items_count = 1'000;
+        ThreadSafePriorityQueue<int> pq{heaps_count};
+
+        for (int i = 0; i < items_count; ++i)
+            pq.push((i * 7919) % items_count); // permutation of 0 .. items_count - 1
+
+        vector<bool> is_popped(items_count);
+        long sum_of_rank_errors = 0;
+        int item;
+        while (pq.try_pop(item))
+        {
+            sum_of_rank_errors += count(is_popped.begin() + item + 1, is_popped.end(), false);
+            is_popped[item] = true;
+        }
+
+        REQUIRE(static_cast<double>(sum_of_rank_errors) / items_count < 2 * heaps_count);
+    }
+
+    SECTION("uses custom comparer")
+    {
+        ThreadSafePriorityQueue<int, greater<int>> pq{1};
+        pq.push(vector{5, 2, 8});
+
+        int item;
+        pq.pop(item);
+
+        REQUIRE(item == 2);
+    }
+
+    SECTION("supports move-only items")
+    {
+        ThreadSafePriorityQueue<unique_ptr<int>, function<bool(const unique_ptr<int>&, const unique_ptr<int>&)>> pq{
+            2, [](const auto& a, const auto& b) { return *a < *b; }};
+
+        pq.push(make_unique<int>(1));
+        pq.push(make_unique<int>(2));
+
+        unique_ptr<int> item;
+        REQUIRE(pq.try_pop(item));
+        REQUIRE(item != nullptr);
+    }
+
+    SECTION("client waits when poping from empty")
+    {
+        ThreadSafePriorityQueue<int> pq;
+        int item = 0;
+
+        thread thd{[&pq, &item] { pq.pop(item); }};
+
+        this_thread::sleep_for(100ms);
+        pq.push(42);
+        thd.join();
+
+        REQUIRE(item == 42);
+    }
+
+    SECTION("many producers and consumers - every item is popped exactly once")
+    {
+        ThreadSafePriorityQueue<int> pq{8};
+
+        const int producers_count = 4;
+        const int consumers_count = 4;
+        const int items_per_producer = 10'000;
+        const int total = producers_count * items_per_producer;
+
+        vector<vector<int>> popped(consumers_count);
+        vector<thread> threads;
+
+        for (int c = 0; c < consumers_count; ++c)
+            threads.emplace_back([&pq, &popped, c] {
+                for (int i = 0; i < total / consumers_count; ++i)
+                {
+                    int item;
+                    pq.pop(item);
+                    popped[c].push_back(item);
+                }
+            });
+
+        for (int p = 0; p < producers_count; ++p)
+            threads.emplace_back([&pq, p] {
+                for (int i = 0; i < items_per_producer; ++i)
+                    pq.push(p * items_per_producer + i);
+            });
+
+        for (auto& thd : threads)
+            thd.join();
+
+        vector<int> all;
+        for (const auto& items : popped)
+            all.insert(all.end(), items.begin(), items.end());
+
+        sort(all.begin(), all.end());
+        vector<int> expected(total);
+        iota(expected.begin(), expected.end(), 0);
+        REQUIRE(all == expected);
+        REQUIRE(pq.empty());
+    }
+
+    SECTION("close wakes up blocked consumers after remaining items are popped")
+    {
+        ThreadSafePriorityQueue<int> pq{2};
+        pq.push(1);
+
+        vector<future<bool>> results;
+        for (int i = 0; i < 3; ++i)
+            results.push_back(async(launch::async, [&pq] { int item; return pq.pop(item); }));
+
+        this_thread::sleep_for(100ms);
+        pq.close();
+
+        REQUIRE(count_if(results.begin(), results.end(), [](auto& r) { return r.get(); }) == 1);
+        REQUIRE(pq.try_push(2) == false);
+    }
+
+    SECTION("every push racing with close is either rejected or popped")
+    {
+        for (int round = 0; round < 20; ++round)
+        {
+            ThreadSafePriorityQueue<int> pq{4};
+            atomic<int> pushed_count{0};
+            atomic<int> popped_count{0};
+
+            vector<thread> threads;
+            for (int c = 0; c < 2; ++c)
+                threads.emplace_back([&pq, &popped_count] {
+                    int item;
+                    while (pq.pop(item))
+                        ++popped_count;
+                });
+
+            for (int p = 0; p < 2; ++p)
+                threads.emplace_back([&pq, &pushed_count] {
+                    for (int i = 0; pq.try_push(i); ++i)
+                        ++pushed_count;
+                });
+
+            this_thread::sleep_for(1ms);
+            pq.close();
+
+            for (auto& thd : threads)
+                thd.join();
+
+            REQUIRE(popped_count == pushed_count);
+            REQUIRE(pq.empty());
+        }
+    }
+}
@@ -90,4 +90,69 @@ TEST_CASE("ThreadSafeQueue")
 
         REQUIRE(std::none_of(items.begin(), items.end(), [](int x) { return x == 0; }));
     }
+
+    SECTION("no wake-up is lost when consumers block repeatedly")
+    {
+        ThreadSafeQueue<int> pong;
+        const int round_trips = 10'000;
+
+        thread responder{[&tsq, &pong] {
+            int token = 0;
+            for (int i = 0; i < round_trips; ++i)
+            {
+                tsq.pop(token);
+                pong.push(token + 1);
+            }
+        }};
+
+        int token = 0;
+        for (int i = 0; i < round_trips; ++i)
+        {
+            tsq.push(token);
+            pong.pop(token);
+        }
+        responder.join();
+
+        REQUIRE(token == round_trips);
+    }
+
+    SECTION("close")
+    {
+        SECTION("try_push fails after close")
+        {
+            tsq.close();
+
+            REQUIRE(tsq.is_closed());
+            REQUIRE(tsq.try_push(1) == false);
+            REQUIRE_THROWS_AS(tsq.push(1), std::logic_error);
+        }
+
+        SECTION("items pushed before close can be popped")
+        {
+            tsq.push(1);
+            tsq.push(2);
+            tsq.close();
+
+            int item;
+            REQUIRE(tsq.pop(item));
+            REQUIRE(item == 1);
+            REQUIRE(tsq.pop(item));
+            REQUIRE(item == 2);
+            REQUIRE(tsq.pop(item) == false);
+        }
+
+        SECTION("wakes up all blocked consumers")
+        {
+            const int size = 4;
+            vector<future<bool>> results;
+
+            for (int i = 0; i < size; ++i)
+                results.push_back(async(launch::async, [&tsq] { int item; return tsq.pop(item); }));
+
+            this_thread::sleep_for(100ms);
+            tsq.close();
+
+            REQUIRE(std::none_of(results.begin(), results.end(), [](auto& r) { return r.get(); }));
+        }
+    }
 }
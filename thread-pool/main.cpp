@@ -1,3 +1,5 @@
+#include "thread_pool.hpp"
+#include "thread_safe_priority_queue.hpp"
 #include "thread_safe_queue.hpp"
 
 #include <cassert>
@@ -13,13 +15,6 @@
 
 using namespace std::literals;
 
-#if __cplusplus >= 202302L
-using Task = std::move_only_function<void()>;
-#else
-using Task = std::function<void()>;
-#endif
-
-
 #if __cplusplus < 202302L
 namespace PoisoiningPill
 {
@@ -79,65 +74,6 @@ namespace PoisoiningPill
 } // namespace PoisoiningPill
 #endif
 
-class ThreadPool
-{
-public:
-    ThreadPool(size_t size)
-    {
-        threads_.reserve(size);
-        for (auto i{0}; i < size; i++)
-        {
-            threads_.push_back(std::jthread{[this]() { run(); }});
-        }
-    }
-
-    ThreadPool(const ThreadPool&) = delete;
-    ThreadPool& operator=(const ThreadPool&) = delete;
-    ThreadPool(ThreadPool&&) = delete;
-    ThreadPool& operator=(ThreadPool&&) = delete;
-
-    ~ThreadPool()
-    {
-        for (size_t i = 0; i < threads_.size(); ++i)
-            tasks_.push([this] { is_done_ = true; });
-    }
-
-    template <typename TTask>
-    auto submit(TTask&& task) -> std::future<decltype(task())>
-    {
-        using TResult = decltype(task());
-
-#if __cplusplus >= 202302L
-        std::packaged_task<TResult()> pt(std::forward<TTask>(task));
-        std::future<TResult> f_result = pt.get_future();
-        tasks_.push(std::move(pt));
-#else
-        // work-around for std::function as Task
-        auto pt = std::make_shared<std::packaged_task<TResult()>>(std::forward<TTask>(task));
-        std::future<TResult> f_result = pt->get_future();
-        tasks_.push([pt] { (*pt)(); });
-#endif
-
-        return f_result;
-    }
-
-private:
-    ThreadSafeQueue<Task> tasks_;
-    std::vector<std::jthread> threads_;
-    std::atomic<bool> is_done_{false};
-
-    void run()
-    {
-        while (!is_done_)
-        {
-            Task task;
-            tasks_.pop(task); // waiting for task
-
-            task(); // executing task in working thread
-        }
-    }
-};
-
 void background_work(size_t id, const std::string& text, std::chrono::milliseconds delay)
 {
     std::cout << "bw#" << id << " has started..." << std::endl;
@@ -198,5 +134,20 @@ int main()
         }
     }
 
+    {
+        std::cout << "\nPriority thread pool (single worker)..." << std::endl;
+
+        ThreadPool<ThreadSafePriorityQueue<PrioritizedTask>> prio_pool(1);
+
+        prio_pool.submit([] { std::this_thread::sleep_for(100ms); }); // keeps the worker busy while tasks are queued
+
+        std::vector<std::future<void>> f_tasks;
+        for (int priority : {1, 5, 3, 10, 2})
+            f_tasks.push_back(prio_pool.submit([priority] { std::cout << "Task with priority " << priority << std::endl; }, priority));
+
+        for (auto& ft : f_tasks)
+            ft.wait();
+    }
+
     std::cout << "Main thread ends..." << std::endl;
 }
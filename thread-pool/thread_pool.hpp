@@ -0,0 +1,122 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include "thread_safe_queue.hpp"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if __cplusplus >= 202302L
+using Task = std::move_only_function<void()>;
+#else
+using Task = std::function<void()>;
+#endif
+
+// item of ThreadSafePriorityQueue<PrioritizedTask> - tasks with higher priority are executed first
+// (ordering of the multi-heap queue is relaxed - tasks with close priorities may be swapped)
+struct PrioritizedTask
+{
+    int priority{};
+    Task task;
+
+    void operator()()
+    {
+        task();
+    }
+
+    bool operator<(const PrioritizedTask& other) const
+    {
+        return priority < other.priority;
+    }
+};
+
+template <typename TTaskQueue = ThreadSafeQueue<Task>>
+class ThreadPool
+{
+    using QueueItem = typename TTaskQueue::value_type;
+
+public:
+    ThreadPool(size_t size)
+        : tasks_{make_task_queue(size)}
+    {
+        threads_.reserve(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            threads_.push_back(std::jthread{[this]() { run(); }});
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    ~ThreadPool()
+    {
+        tasks_.close(); // workers execute tasks left in the queue and exit
+    }
+
+    size_t size() const
+    {
+        return threads_.size();
+    }
+
+    // priority is used only when tasks are stored in a priority queue
+    template <typename TTask>
+    auto submit(TTask&& task, int priority = 0) -> std::future<decltype(task())>
+    {
+        using TResult = decltype(task());
+
+#if __cplusplus >= 202302L
+        std::packaged_task<TResult()> pt(std::forward<TTask>(task));
+        std::future<TResult> f_result = pt.get_future();
+        tasks_.push(make_item(std::move(pt), priority));
+#else
+        // work-around for std::function as Task
+        auto pt = std::make_shared<std::packaged_task<TResult()>>(std::forward<TTask>(task));
+        std::future<TResult> f_result = pt->get_future();
+        tasks_.push(make_item([pt] { (*pt)(); }, priority));
+#endif
+
+        return f_result;
+    }
+
+private:
+    TTaskQueue tasks_;
+    std::vector<std::jthread> threads_;
+
+    // a relaxed priority queue is sized for the number of workers - fewer heaps give a better order of tasks
+    static TTaskQueue make_task_queue(size_t workers_count)
+    {
+        if constexpr (requires { TTaskQueue::heaps_count_for(workers_count); })
+            return TTaskQueue{TTaskQueue::heaps_count_for(workers_count)};
+        else
+            return TTaskQueue{};
+    }
+
+    static QueueItem make_item(Task task, int priority)
+    {
+        if constexpr (std::is_same_v<QueueItem, Task>)
+            return task;
+        else
+            return QueueItem{priority, std::move(task)};
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            QueueItem task;
+            if (!tasks_.pop(task)) // waiting for task - false when the queue is closed and drained
+                break;
+
+            task(); // executing task in working thread
+        }
+    }
+};
+
+#endif // THREAD_POOL_HPP